@@ -9,6 +9,7 @@
 
 #include "Adafruit_mfGFX.h"   // Core graphics library
 #include "RGBmatrixPanel.h" // Hardware-specific library
+#include "RGBmatrixScheduler.h" // Refresh-locked pacing
 #include "math.h"
 
 
@@ -46,6 +47,11 @@
 // until the first call to swapBuffers().  This is normal.
 RGBmatrixPanel matrix(A, B, C, CLK, LAT, OE, true);
 
+// A new animation frame about every 75 ms, in step with the display
+// rather than delay().  How many refresh frames that is depends on the
+// board, so setPeriod() measures it once refresh is running.
+RGBmatrixScheduler sched(matrix);
+
 static const int8_t sinetab[256] = {
      0,   2,   5,   8,  11,  15,  18,  21,
     24,  27,  30,  33,  36,  39,  42,  45,
@@ -83,6 +89,7 @@ static const int8_t sinetab[256] = {
 
 void setup() {
   matrix.begin();
+  sched.setPeriod(75);
 }
 
 const float radius1  = 65.2, radius2  = 92.0, radius3  = 163.2, radius4  = 176.8,
@@ -127,6 +134,6 @@ void loop() {
 
   matrix.swapBuffers(false);
 
-  delay(75);	// Slow down animation!
+  sched.wait();	// Slow down animation!
 }
 
@@ -9,6 +9,7 @@
 
 #include "Adafruit_mfGFX.h"   // Core graphics library
 #include "RGBmatrixPanel.h" // Hardware-specific library
+#include "RGBmatrixScheduler.h" // Refresh-locked pacing
 #include "math.h"
 
 
@@ -43,6 +44,11 @@
 
 RGBmatrixPanel matrix(A, B, C, D, CLK, LAT, OE, false);
 
+// A new animation frame about every 75 ms, in step with the display
+// rather than delay().  How many refresh frames that is depends on the
+// board, so setPeriod() measures it once refresh is running.
+RGBmatrixScheduler sched(matrix);
+
 static const int8_t sinetab[256] = {
      0,   2,   5,   8,  11,  15,  18,  21,
     24,  27,  30,  33,  36,  39,  42,  45,
@@ -80,6 +86,7 @@ static const int8_t sinetab[256] = {
 
 void setup() {
   matrix.begin();
+  sched.setPeriod(75);
 }
 
 const float radius1  = 16.3, radius2  = 23.0, radius3  = 40.8, radius4  = 44.2,
@@ -122,6 +129,6 @@ void loop() {
   angle4 -= 0.15;
   hueShift += 2;
 
-  delay(75);	// Slow down animation!
+  sched.wait();	// Slow down animation!
 }
 
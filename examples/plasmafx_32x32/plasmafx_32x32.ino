@@ -0,0 +1,51 @@
+// Fixed-point plasma demo for Adafruit RGBmatrixPanel library.
+// The same effect as the plasma example, rendered by RGBmatrixEffects
+// without floating point or per-pixel drawPixel() calls, double-buffered
+// on a 32x32 RGB LED matrix (http://www.adafruit.com/products/607) and
+// animated as fast as the panel refreshes.  For a chain of panels, just
+// change the width argument.
+
+#include "Adafruit_mfGFX.h"   // Core graphics library
+#include "RGBmatrixPanel.h" // Hardware-specific library
+#include "RGBmatrixEffects.h"
+
+// Modify for version of RGBShieldMatrix that you have
+// HINT: Maker Faire 2016 Kit and later have shield version 4 (3 prior to that)
+//
+// NOTE: Version 4 of the RGBMatrix Shield only works with Photon and Electron (not Core)
+#define RGBSHIELDVERSION		4
+
+/** Define RGB matrix panel GPIO pins **/
+#if (RGBSHIELDVERSION == 4)		// Newest shield with SD socket onboard
+	#warning "new shield"
+	#define CLK	D6
+	#define OE	D7
+	#define LAT	TX
+	#define A  	A0
+	#define B  	A1
+	#define C  	A2
+	#define D	RX
+#else
+	#warning "old shield"
+	#define CLK	D6
+	#define OE 	D7
+	#define LAT	A4
+	#define A  	A0
+	#define B  	A1
+	#define C  	A2
+	#define D	A3
+#endif
+/****************************************/
+
+
+RGBmatrixPanel matrix(A, B, C, D, CLK, LAT, OE, true);
+RGBmatrixEffects fx(matrix);
+
+void setup() {
+  matrix.begin();
+}
+
+void loop() {
+  fx.plasma();
+  matrix.swapBuffers(false);  // Waits for the end of the current frame
+}
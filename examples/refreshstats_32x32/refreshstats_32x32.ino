@@ -0,0 +1,80 @@
+// refreshstats demo for Adafruit RGBmatrixPanel library.
+// Shows a test pattern on a 32x32 RGB LED matrix
+// (http://www.adafruit.com/products/607) and reports the achieved
+// refresh rate, interrupt rate and CPU load over USB serial, switching
+// every few seconds between the two refresh orders and, in the default
+// order, setPlaneMerge(1) and (2), for comparison on your board.
+
+#include "Adafruit_mfGFX.h"   // Core graphics library
+#include "RGBmatrixPanel.h" // Hardware-specific library
+
+
+// Modify for version of RGBShieldMatrix that you have
+// HINT: Maker Faire 2016 Kit and later have shield version 4 (3 prior to that)
+//
+// NOTE: Version 4 of the RGBMatrix Shield only works with Photon and Electron (not Core)
+#define RGBSHIELDVERSION		4
+
+/** Define RGB matrix panel GPIO pins **/
+#if (RGBSHIELDVERSION == 4)		// Newest shield with SD socket onboard
+	#warning "new shield"
+	#define CLK	D6
+	#define OE	D7
+	#define LAT	TX
+	#define A  	A0
+	#define B  	A1
+	#define C  	A2
+	#define D	RX
+#else
+	#warning "old shield"
+	#define CLK	D6
+	#define OE 	D7
+	#define LAT	A4
+	#define A  	A0
+	#define B  	A1
+	#define C  	A2
+	#define D	A3
+#endif
+/****************************************/
+
+
+RGBmatrixPanel matrix(A, B, C, D, CLK, LAT, OE, false);
+uint8_t mode = 0; // 0-2: row planes with 0-2 planes merged, 3: interleaved
+
+void setup() {
+  Serial.begin(115200);
+  matrix.begin(SCAN_ROW_PLANES);
+  for(uint8_t y=0; y<32; y++)
+    matrix.drawFastHLine(0, y, 32, matrix.ColorHSV(y * 48, 255, 255, true));
+}
+
+void loop() {
+  RefreshStats s;
+
+  delay(5000);
+  matrix.getStats(s);
+  if(mode < 3) {
+    Serial.print("row planes, merge ");
+    Serial.print(mode);
+    Serial.print(": ");
+  } else {
+    Serial.print("interleaved: ");
+  }
+  Serial.print(s.frames * 1000 / (s.micros / 1000));
+  Serial.print(" Hz, ");
+  Serial.print(s.interrupts * 1000 / (s.micros / 1000));
+  Serial.print(" interrupts/s, ");
+  Serial.print(s.isrCycles / (s.micros / 100) / (SystemCoreClock / 1000000));
+  Serial.println("% CPU");
+
+  // Next mode.  begin() again to change order (buffer contents are kept);
+  // the plane merge can change on the fly.
+  mode = (mode + 1) & 3;
+  if(mode == 3) {
+    matrix.begin(SCAN_INTERLEAVED);
+  } else {
+    if(mode == 0) matrix.begin(SCAN_ROW_PLANES);
+    matrix.setPlaneMerge(mode);
+    matrix.resetStats();
+  }
+}
@@ -8,6 +8,8 @@
 
 #include "Adafruit_mfGFX.h"   // Core graphics library
 #include "RGBmatrixPanel.h" // Hardware-specific library
+#include "RGBmatrixGlyphs.h" // Cached text rendering
+#include "RGBmatrixScheduler.h" // Refresh-locked pacing
 #include "math.h"
 
 
@@ -44,6 +46,15 @@
 // until the first call to swapBuffers().  This is normal.
 RGBmatrixPanel matrix(A, B, C, CLK, LAT, OE, true);
 
+// Text is drawn through a glyph cache: each character is rendered once,
+// then blitted as pre-encoded column runs every frame.
+RGBmatrixGlyphs text(matrix, 32);
+
+// A new animation frame about every 75 ms, in step with the display
+// rather than delay().  How many refresh frames that is depends on the
+// board, so setPeriod() measures it once refresh is running.
+RGBmatrixScheduler sched(matrix);
+
 
 const char str[] = "Adafruit 16x32 RGB LED Matrix";
 int    textX   = matrix.width(),
@@ -62,8 +73,8 @@ static const uint16_t ballcolor[3] = {
 
 void setup() {
   matrix.begin();
-  matrix.setTextWrap(false); // Allow text to run off right edge
-  matrix.setTextSize(2);
+  sched.setPeriod(75);
+  text.setTextSize(2);
 }
 
 void loop() {
@@ -87,9 +98,9 @@ void loop() {
   }
 
   // Draw big scrolly text on top
-  matrix.setTextColor(matrix.ColorHSV(hue, 255, 255, true));
-  matrix.setCursor(textX, 1);
-  matrix.print(str);
+  text.setTextColor(matrix.ColorHSV(hue, 255, 255, true));
+  text.setCursor(textX, 1);
+  text.print(str);
 
   // Move text left (w/wrap), increase hue
   if((--textX) < textMin) textX = matrix.width();
@@ -99,5 +110,5 @@ void loop() {
   // Update display
   matrix.swapBuffers(false);
 
-  delay(75);	// Slow down animation!
+  sched.wait();	// Slow down animation!
 }
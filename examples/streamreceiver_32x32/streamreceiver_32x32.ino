@@ -0,0 +1,55 @@
+// streamreceiver demo for Adafruit RGBmatrixPanel library.
+// Displays frames pushed from a host over USB serial on our 32x32
+// RGB LED matrix: http://www.adafruit.com/products/607
+//
+// Each frame is sent as one or more row chunks (see RGBmatrixReceiver.h).
+// For example, a whole 32x32 frame of 5/6/5 pixels is the 4-byte header
+//   0xA5 'C' 0 32
+// followed by 32 * 32 * 2 bytes of little-endian pixel data.
+
+#include "Adafruit_mfGFX.h"   // Core graphics library
+#include "RGBmatrixPanel.h" // Hardware-specific library
+#include "RGBmatrixReceiver.h"
+
+
+// Modify for version of RGBShieldMatrix that you have
+// HINT: Maker Faire 2016 Kit and later have shield version 4 (3 prior to that)
+//
+// NOTE: Version 4 of the RGBMatrix Shield only works with Photon and Electron (not Core)
+#define RGBSHIELDVERSION		4
+
+/** Define RGB matrix panel GPIO pins **/
+#if (RGBSHIELDVERSION == 4)		// Newest shield with SD socket onboard
+	#warning "new shield"
+	#define CLK	D6
+	#define OE	D7
+	#define LAT	TX
+	#define A  	A0
+	#define B  	A1
+	#define C  	A2
+	#define D	RX
+#else
+	#warning "old shield"
+	#define CLK	D6
+	#define OE 	D7
+	#define LAT	A4
+	#define A  	A0
+	#define B  	A1
+	#define C  	A2
+	#define D	A3
+#endif
+/****************************************/
+
+
+// Double-buffered, so each frame appears all at once when completed.
+RGBmatrixPanel matrix(A, B, C, D, CLK, LAT, OE, true);
+RGBmatrixReceiver receiver(matrix, Serial);
+
+void setup() {
+  Serial.begin(115200);
+  matrix.begin();
+}
+
+void loop() {
+  receiver.poll();
+}
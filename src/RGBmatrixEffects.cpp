@@ -0,0 +1,144 @@
+/*
+Fixed-point effect generators for the RGBmatrixPanel library, after the
+plasma examples: same sine table and wave layout, without the floating
+point, per-pixel multiplies, ColorHSV() or drawPixel() calls.
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include "RGBmatrixEffects.h"
+
+static const int8_t sinetab[256] = {
+     0,   2,   5,   8,  11,  15,  18,  21,
+    24,  27,  30,  33,  36,  39,  42,  45,
+    48,  51,  54,  56,  59,  62,  65,  67,
+    70,  72,  75,  77,  80,  82,  85,  87,
+    89,  91,  93,  96,  98, 100, 101, 103,
+   105, 107, 108, 110, 111, 113, 114, 116,
+   117, 118, 119, 120, 121, 122, 123, 123,
+   124, 125, 125, 126, 126, 126, 126, 126,
+   127, 126, 126, 126, 126, 126, 125, 125,
+   124, 123, 123, 122, 121, 120, 119, 118,
+   117, 116, 114, 113, 111, 110, 108, 107,
+   105, 103, 101, 100,  98,  96,  93,  91,
+    89,  87,  85,  82,  80,  77,  75,  72,
+    70,  67,  65,  62,  59,  56,  54,  51,
+    48,  45,  42,  39,  36,  33,  30,  27,
+    24,  21,  18,  15,  11,   8,   5,   2,
+     0,  -3,  -6,  -9, -12, -16, -19, -22,
+   -25, -28, -31, -34, -37, -40, -43, -46,
+   -49, -52, -55, -57, -60, -63, -66, -68,
+   -71, -73, -76, -78, -81, -83, -86, -88,
+   -90, -92, -94, -97, -99,-101,-102,-104,
+  -106,-108,-109,-111,-112,-114,-115,-117,
+  -118,-119,-120,-121,-122,-123,-124,-124,
+  -125,-126,-126,-127,-127,-127,-127,-127,
+  -128,-127,-127,-127,-127,-127,-126,-126,
+  -125,-124,-124,-123,-122,-121,-120,-119,
+  -118,-117,-115,-114,-112,-111,-109,-108,
+  -106,-104,-102,-101, -99, -97, -94, -92,
+   -90, -88, -86, -83, -81, -78, -76, -73,
+   -71, -68, -66, -63, -60, -57, -55, -52,
+   -49, -46, -43, -40, -37, -34, -31, -28,
+   -25, -22, -19, -16, -12,  -9,  -6,  -3
+};
+
+// Plasma waves, as in plasma_32x32: center of the orbit and its radius
+// in tenths of a pixel on a 32x32 display, phase step per frame in 8.8
+// turns, and how far the squared distance is shifted down (ring spacing)
+static const struct {
+  int16_t cx, cy, radius, speed;
+  uint8_t shift;
+} waves[4] = {
+  { 161,  87, 163,   313, 2 },
+  { 116,  65, 230,  -730, 2 },
+  { 234, 140, 408,  1356, 3 },
+  {  41, -29, 442, -1565, 3 } };
+
+int8_t RGBmatrixEffects::sin8(uint8_t angle) {
+  return sinetab[angle];
+}
+
+int8_t RGBmatrixEffects::cos8(uint8_t angle) {
+  return sinetab[(uint8_t)(angle + 64)];
+}
+
+RGBmatrixEffects::RGBmatrixEffects(RGBmatrixPanel &panel) :
+  matrix(panel), linebuff(NULL), lineAlloc(0), hue(0) {
+  memset(angle, 0, sizeof(angle));
+  setPalette(NULL);
+}
+
+RGBmatrixEffects::~RGBmatrixEffects(void) {
+  free(linebuff);
+}
+
+void RGBmatrixEffects::setPalette(const uint16_t *colors) {
+  uint16_t i;
+
+  if(colors) {
+    memcpy(palette, colors, sizeof(palette));
+    return;
+  }
+  for(i=0; i<256; i++)
+    palette[i] = matrix.ColorHSV(i * 6, 255, 255, true);
+}
+
+// Each wave contributes sin(d) for its squared distance d from a moving
+// center.  Coordinates are 8.8 fixed point on a 32-unit reference grid
+// spanning the display's longer side, 'step' units per pixel, so the
+// pattern looks the same at any size.  Along a row d grows by a
+// difference that itself grows by 2*step*step per pixel, and likewise
+// for the rows' starting points, so no multiplies are needed per pixel.
+boolean RGBmatrixEffects::plasma(void) {
+  boolean  swapped = matrix.getRotation() & 1;
+  int16_t  w = swapped ? matrix.height() : matrix.width(),
+           h = swapped ? matrix.width()  : matrix.height(),
+           x, y, sum;
+  int32_t  step = (32L * 256) / ((w > h) ? w : h), step2 = 2 * step * step,
+           ux, vy, d[4], dd[4], ddx[4], rowd[4], rowdd[4];
+  uint8_t  i, sh[4];
+
+  if(w > lineAlloc) {
+    free(linebuff);
+    lineAlloc = (NULL != (linebuff = (uint16_t *)malloc(w * 2))) ? w : 0;
+  }
+  if(linebuff == NULL) return false;
+
+  for(i=0; i<4; i++) {
+    // Offset of pixel 0,0 from this frame's wave center
+    ux = -(((int32_t)waves[i].cx * 256 +
+      (int32_t)cos8(angle[i] >> 8) * waves[i].radius * 2) / 10);
+    vy = -(((int32_t)waves[i].cy * 256 +
+      (int32_t)sin8(angle[i] >> 8) * waves[i].radius * 2) / 10);
+    rowd[i]  = ux * ux + vy * vy;         // d at the start of row 0
+    rowdd[i] = 2 * vy * step + step * step; // ...change to row 1
+    dd[i]    = 2 * ux * step + step * step; // Change from column 0 to 1
+    sh[i]    = 16 + waves[i].shift;
+    angle[i] += waves[i].speed;
+  }
+
+  for(y=0; y<h; y++) {
+    for(i=0; i<4; i++) {
+      d[i]   = rowd[i];
+      ddx[i] = dd[i];
+    }
+    for(x=0; x<w; x++) {
+      sum = sinetab[(uint8_t)(d[0] >> sh[0])] +
+            sinetab[(uint8_t)(d[1] >> sh[1])] +
+            sinetab[(uint8_t)(d[2] >> sh[2])] +
+            sinetab[(uint8_t)(d[3] >> sh[3])];
+      linebuff[x] = palette[(uint8_t)((sum >> 1) + hue)];
+      d[0] += ddx[0]; ddx[0] += step2;
+      d[1] += ddx[1]; ddx[1] += step2;
+      d[2] += ddx[2]; ddx[2] += step2;
+      d[3] += ddx[3]; ddx[3] += step2;
+    }
+    matrix.writeRow(y, linebuff);
+    for(i=0; i<4; i++) {
+      rowd[i]  += rowdd[i];
+      rowdd[i] += step2;
+    }
+  }
+  hue++;
+  return true;
+}
@@ -0,0 +1,51 @@
+
+#pragma once
+
+#include "RGBmatrixPanel.h"
+
+// Procedural backgrounds for RGBmatrixPanel, computed in fixed point.  A
+// shared 256-entry sine table replaces floating point trig, distances
+// are stepped incrementally along each row instead of squared per pixel,
+// and colors come from a 256-entry palette rather than ColorHSV(), with
+// each row written to the back buffer in one RGBmatrixPanel::writeRow()
+// call.  Cheap enough to animate at the refresh rate even on 128-wide
+// chains:
+//
+//   RGBmatrixEffects fx(matrix);
+//   fx.plasma();              // Render the next frame
+//   matrix.swapBuffers(false);
+//
+// Effects are drawn in unrotated panel coordinates and fill the whole
+// display.  The pattern is scaled to the display's longer side.
+
+class RGBmatrixEffects {
+
+ public:
+
+  RGBmatrixEffects(RGBmatrixPanel &panel);
+  ~RGBmatrixEffects(void);
+
+  // Fixed-point sine and cosine: 'angle' 0-255 is one full turn, the
+  // result -128 to 127.
+  static int8_t
+    sin8(uint8_t angle),
+    cos8(uint8_t angle);
+
+  // Use 256 5/6/5 colors for the effects (copied), or NULL to go back to
+  // the default fully saturated hue wheel.
+  void
+    setPalette(const uint16_t *colors);
+  // Render the next frame of a moving plasma (four interfering sets of
+  // rings) into the back buffer.  Returns false if out of memory.
+  boolean
+    plasma(void);
+
+ private:
+
+  RGBmatrixPanel &matrix;
+  uint16_t       *linebuff;    // One row of 5/6/5 pixels
+  uint16_t        lineAlloc,
+                  palette[256],
+                  angle[4];    // Wave center phases, 8.8 turns
+  uint8_t         hue;         // Palette rotation
+};
@@ -0,0 +1,183 @@
+/*
+Frame container format for the RGBmatrixPanel library: headers, run
+length coding and checksums.  Deliberately free of any Particle headers
+so host-side tools can compile it too.
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include <string.h>
+#include "RGBmatrixFrames.h"
+
+static const uint8_t magic[4] = { 'R', 'G', 'B', 'F' };
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+static uint16_t get16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+uint32_t frameBytes(const FrameFileInfo &info) {
+  // Packed: planes-1 bytes per column, plane 0 spread over the spare bits
+  return (uint32_t)info.rows * info.columns *
+    (info.layout ? info.planes : info.planes - 1);
+}
+
+void frameFileHeader(uint8_t *out, const FrameFileInfo &info) {
+  memcpy(out, magic, sizeof(magic));
+  out[4] = FRAMEFILE_VERSION;
+  out[5] = info.layout;
+  out[6] = info.planes;
+  out[7] = info.rows;
+  put16(&out[8],  info.columns);
+  put16(&out[10], info.width);
+  put16(&out[12], info.height);
+  put16(&out[14], info.frames);
+}
+
+void frameHeader(uint8_t *out, const FrameInfo &frame) {
+  out[0] = frame.compression;
+  out[1] = 0;
+  put16(&out[2], frame.delay);
+  put32(&out[4], frame.size);
+  put16(&out[8], frame.checksum);
+  put16(&out[10], 0);
+}
+
+int frameFileParse(const uint8_t *in, uint32_t len, FrameFileInfo &info) {
+  if(len < FRAMEFILE_HEADER)              return FRAMEFILE_TRUNCATED;
+  if(memcmp(in, magic, sizeof(magic)))    return FRAMEFILE_BAD_MAGIC;
+  if(in[4] > FRAMEFILE_VERSION)           return FRAMEFILE_BAD_VERSION;
+  info.version = in[4];
+  info.layout  = in[5];
+  info.planes  = in[6];
+  info.rows    = in[7];
+  info.columns = get16(&in[8]);
+  info.width   = get16(&in[10]);
+  info.height  = get16(&in[12]);
+  info.frames  = get16(&in[14]);
+  if((info.layout > 1) || (info.planes < 2) || !info.rows || !info.columns)
+    return FRAMEFILE_BAD_DATA;
+  return FRAMEFILE_OK;
+}
+
+// Frames vary in size once compressed, so walk the headers from the
+// first to the one wanted
+int frameFind(const uint8_t *in, uint32_t len, uint16_t index,
+  FrameInfo &frame, const uint8_t *&payload) {
+  FrameFileInfo info;
+  uint32_t      pos = FRAMEFILE_HEADER;
+  int           err;
+
+  if((err = frameFileParse(in, len, info)) != FRAMEFILE_OK) return err;
+  if(index >= info.frames) return FRAMEFILE_NO_FRAME;
+
+  for(;;) {
+    if((len - pos) < FRAMEFILE_FRAME) return FRAMEFILE_TRUNCATED;
+    frame.compression = in[pos];
+    frame.delay       = get16(&in[pos + 2]);
+    frame.size        = get32(&in[pos + 4]);
+    frame.checksum    = get16(&in[pos + 8]);
+    pos += FRAMEFILE_FRAME;
+    if(frame.size > (len - pos)) return FRAMEFILE_TRUNCATED;
+    if(!index--) break;
+    pos += frame.size;
+  }
+  payload = &in[pos];
+  return FRAMEFILE_OK;
+}
+
+int frameDecode(const FrameInfo &frame, const uint8_t *payload,
+  uint8_t *out, uint32_t outLen) {
+  const uint8_t *end = payload + frame.size;
+  uint32_t       n, pos = 0;
+  uint8_t        c;
+
+  if(frame.compression == FRAMEFILE_RAW) {
+    if(frame.size != outLen) return FRAMEFILE_MISMATCH;
+    memcpy(out, payload, outLen);
+  } else if(frame.compression == FRAMEFILE_RLE) {
+    while(payload < end) {
+      c = *payload++;
+      if(c < 128) {
+        n = c + 1;
+        if(((uint32_t)(end - payload) < n) || ((outLen - pos) < n))
+          return FRAMEFILE_BAD_DATA;
+        memcpy(&out[pos], payload, n);
+        payload += n;
+      } else {
+        n = c - 125;
+        if((payload == end) || ((outLen - pos) < n))
+          return FRAMEFILE_BAD_DATA;
+        memset(&out[pos], *payload++, n);
+      }
+      pos += n;
+    }
+    if(pos != outLen) return FRAMEFILE_MISMATCH;
+  } else {
+    return FRAMEFILE_BAD_DATA;
+  }
+  return (frameChecksum(out, outLen) == frame.checksum) ?
+    FRAMEFILE_OK : FRAMEFILE_BAD_CHECK;
+}
+
+// Runs of 3 or more equal bytes (common in the matrix buffer: black areas
+// and flat colors) become repeats, anything else is stored literally
+uint32_t frameCompress(const uint8_t *in, uint32_t len, uint8_t *out,
+  uint32_t max) {
+  uint32_t i = 0, lit = 0, n, o = 0;
+
+  while(i < len) {
+    for(n=1; ((i + n) < len) && (n < 130) && (in[i + n] == in[i]); n++);
+    if(n >= 3) {
+      if(lit) { // Flush pending literals first
+        if((o + 1 + lit) > max) return 0;
+        out[o++] = lit - 1;
+        memcpy(&out[o], &in[i - lit], lit);
+        o  += lit;
+        lit = 0;
+      }
+      if((o + 2) > max) return 0;
+      out[o++] = n + 125;
+      out[o++] = in[i];
+      i += n;
+      continue;
+    }
+    i++;
+    if(++lit == 128) {
+      if((o + 1 + lit) > max) return 0;
+      out[o++] = lit - 1;
+      memcpy(&out[o], &in[i - lit], lit);
+      o  += lit;
+      lit = 0;
+    }
+  }
+  if(lit) {
+    if((o + 1 + lit) > max) return 0;
+    out[o++] = lit - 1;
+    memcpy(&out[o], &in[i - lit], lit);
+    o += lit;
+  }
+  return o;
+}
+
+uint16_t frameChecksum(const uint8_t *data, uint32_t len) {
+  uint16_t a = 0, b = 0;
+
+  while(len--) {
+    a = (a + *data++) % 255;
+    b = (b + a) % 255;
+  }
+  return (b << 8) | a;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Container format for frames in the RGBmatrixPanel buffer format, for
+// storing images and animations and moving them between devices and
+// host tools.  Plain C++ with no Particle dependencies, so the same code
+// builds into firmware and into converters on a PC.
+//
+// A file is a 16-byte header followed by one or more frames, each a
+// 12-byte frame header and its payload.  All multi-byte fields are
+// little-endian.
+//
+//   File header
+//   0   4  'R' 'G' 'B' 'F'
+//   4   1  version (FRAMEFILE_VERSION)
+//   5   1  buffer layout: LAYOUT_PACKED or LAYOUT_UNPACKED
+//   6   1  bitplanes (4)
+//   7   1  scanlines per frame (RGBmatrixPanel::scanRows())
+//   8   2  columns per scanline (scanLineBytes() / bytes per column)
+//   10  2  display width in pixels (unrotated, informational)
+//   12  2  display height
+//   14  2  frame count
+//
+//   Frame header
+//   0   1  compression: FRAMEFILE_RAW or FRAMEFILE_RLE
+//   1   1  reserved, 0
+//   2   2  delay before the next frame, milliseconds
+//   4   4  payload bytes
+//   8   2  checksum of the uncompressed frame (frameChecksum())
+//   10  2  reserved, 0
+//
+// An uncompressed frame is scanRows() scanlines of scanLineBytes()
+// each, exactly as held in the matrix buffer.  FRAMEFILE_RLE payloads
+// are a series of runs, each a control byte n followed by either n+1
+// literal bytes (n < 128) or one byte to repeat n-125 times (n >= 128).
+//
+// A file only loads into a panel with the same layout, planes, scanlines
+// and columns; the loaders check this and every frame's checksum.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FRAMEFILE_VERSION     1
+#define FRAMEFILE_HEADER     16 // Bytes in the file header
+#define FRAMEFILE_FRAME      12 // ...and each frame header
+
+#define FRAMEFILE_RAW         0 // Frame compression
+#define FRAMEFILE_RLE         1
+
+// Results from the parse and decode functions
+#define FRAMEFILE_OK          0
+#define FRAMEFILE_TRUNCATED  -1 // Data ends early
+#define FRAMEFILE_BAD_MAGIC  -2 // Not a frame file
+#define FRAMEFILE_BAD_VERSION -3 // Newer version than this code knows
+#define FRAMEFILE_MISMATCH   -4 // Frames don't fit the panel or buffer
+#define FRAMEFILE_BAD_DATA   -5 // Corrupt compressed data
+#define FRAMEFILE_BAD_CHECK  -6 // Checksum doesn't match
+#define FRAMEFILE_NO_FRAME   -7 // Frame index beyond the end
+
+typedef struct {
+  uint8_t  version, layout, planes, rows;
+  uint16_t columns, width, height, frames;
+} FrameFileInfo;
+
+typedef struct {
+  uint8_t  compression;
+  uint16_t delay;
+  uint32_t size;      // Payload bytes
+  uint16_t checksum;
+} FrameInfo;
+
+// Bytes in one uncompressed frame described by 'info'
+uint32_t frameBytes(const FrameFileInfo &info);
+
+// Writers: store a header at 'out' (FRAMEFILE_HEADER or FRAMEFILE_FRAME
+// bytes).  The file header's version is always FRAMEFILE_VERSION.
+void frameFileHeader(uint8_t *out, const FrameFileInfo &info);
+void frameHeader(uint8_t *out, const FrameInfo &frame);
+
+// Loaders: check and unpack the file header at the start of 'in', or the
+// header of frame 'index', returning its payload address.  Results are
+// FRAMEFILE_OK or one of the errors above.
+int frameFileParse(const uint8_t *in, uint32_t len, FrameFileInfo &info);
+int frameFind(const uint8_t *in, uint32_t len, uint16_t index,
+  FrameInfo &frame, const uint8_t *&payload);
+
+// Unpack a frame's payload into 'out' ('outLen' bytes, which it must fill
+// exactly) and verify its checksum.
+int frameDecode(const FrameInfo &frame, const uint8_t *payload,
+  uint8_t *out, uint32_t outLen);
+
+// Compress 'len' bytes into 'out' (at most 'max' bytes).  Returns the
+// compressed size, or 0 if it wouldn't fit, in which case the frame
+// should be stored raw.
+uint32_t frameCompress(const uint8_t *in, uint32_t len, uint8_t *out,
+  uint32_t max);
+
+// Fletcher-16 of an uncompressed frame
+uint16_t frameChecksum(const uint8_t *data, uint32_t len);
@@ -0,0 +1,159 @@
+/*
+Glyph cache for the RGBmatrixPanel library.  Characters are rendered
+once through Adafruit_GFX into column bit masks, then drawn as vertical
+runs of a pre-encoded color straight into the matrix buffer.
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include "RGBmatrixGlyphs.h"
+
+#define GLYPH_MAX 32 // Largest cacheable glyph, either dimension
+
+// Off-screen Adafruit_GFX target that just records which pixels a glyph
+// sets, one bit mask per column.  Drawing with the real GFX text code
+// keeps the cache in step with whatever font is selected.
+class GlyphCanvas : public Adafruit_GFX {
+
+ public:
+
+  GlyphCanvas(void) : Adafruit_GFX(GLYPH_MAX, GLYPH_MAX) { }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t /*c*/) {
+    if((x < 0) || (y < 0)) return;
+    if((x >= GLYPH_MAX) || (y >= GLYPH_MAX)) overflow = true;
+    else cols[x] |= 1UL << y;
+  }
+
+  // Render one character; returns cursor advance
+  int16_t render(uint8_t c, uint8_t size, uint8_t f) {
+    memset(cols, 0, sizeof(cols));
+    overflow = false;
+    setFont(f);
+    setTextSize(size);
+    setTextWrap(false);
+    setTextColor(1);   // No background
+    setCursor(0, 0);
+    write(c);
+    advance = cursor_x;
+    if(advance > GLYPH_MAX) overflow = true;
+    return advance;
+  }
+
+  uint32_t cols[GLYPH_MAX];
+  int16_t  advance;
+  boolean  overflow;
+};
+
+static GlyphCanvas canvas;
+
+RGBmatrixGlyphs::RGBmatrixGlyphs(RGBmatrixPanel &panel, uint8_t entries) :
+  matrix(panel), cursor_x(0), cursor_y(0), next(0), textsize(1), font(0) {
+
+  nEntries = (NULL != (cache = (Glyph *)calloc(entries, sizeof(Glyph)))) ?
+    entries : 0;
+  setTextColor(0xFFFF);
+}
+
+RGBmatrixGlyphs::~RGBmatrixGlyphs(void) {
+  flush();
+  free(cache);
+}
+
+void RGBmatrixGlyphs::setCursor(int16_t x, int16_t y) {
+  cursor_x = x;
+  cursor_y = y;
+}
+
+int16_t RGBmatrixGlyphs::getCursorX(void) {
+  return cursor_x;
+}
+
+int16_t RGBmatrixGlyphs::getCursorY(void) {
+  return cursor_y;
+}
+
+void RGBmatrixGlyphs::setTextColor(uint16_t c) {
+  color = c;
+  matrix.encodeColor(c, packed); // Once per color, not per pixel
+}
+
+void RGBmatrixGlyphs::setTextSize(uint8_t s) {
+  textsize = (s > 0) ? s : 1;
+}
+
+// Also selects the font on the matrix itself, which draws any glyphs too
+// large to cache.
+void RGBmatrixGlyphs::setFont(uint8_t f) {
+  font = f;
+  matrix.setFont(f);
+}
+
+void RGBmatrixGlyphs::flush(void) {
+  for(uint8_t i=0; i<nEntries; i++) {
+    free(cache[i].cols);
+    cache[i].cols = NULL;
+  }
+}
+
+// Find glyph in cache, rendering it into the next slot (round robin) if
+// absent.  Returns NULL if the glyph is too large to cache.
+RGBmatrixGlyphs::Glyph *RGBmatrixGlyphs::lookup(uint8_t c) {
+  Glyph   *g;
+  int16_t  advance;
+  uint8_t  i;
+
+  for(i=0, g=cache; i<nEntries; i++, g++) {
+    if(g->cols && (g->c == c) && (g->size == textsize) && (g->font == font))
+      return g;
+  }
+
+  advance = canvas.render(c, textsize, font);
+  if(canvas.overflow || (nEntries == 0)) return NULL;
+
+  g = &cache[next];
+  if(++next >= nEntries) next = 0;
+  free(g->cols);
+  if(NULL == (g->cols = (uint32_t *)malloc((advance ? advance : 1) *
+    sizeof(uint32_t)))) return NULL;
+  memcpy(g->cols, canvas.cols, advance * sizeof(uint32_t));
+  g->c       = c;
+  g->size    = textsize;
+  g->font    = font;
+  g->advance = advance;
+  return g;
+}
+
+size_t RGBmatrixGlyphs::write(uint8_t c) {
+  Glyph   *g;
+  uint32_t m;
+  uint8_t  i, y, n;
+
+  if(c == '\n') {
+    cursor_x  = 0;
+    cursor_y += textsize * 8;
+    return 1;
+  }
+  if(c == '\r') return 1;
+
+  if(NULL == (g = lookup(c))) {
+    // Uncacheable; canvas.render() still measured the advance
+    matrix.drawChar(cursor_x, cursor_y, c, color, color, textsize);
+    cursor_x += canvas.advance;
+    return 1;
+  }
+
+  // Each column is drawn as runs of set bits
+  for(i=0; i<g->advance; i++) {
+    for(m=g->cols[i], y=0; m; ) {
+      n  = __builtin_ctz(m);     // Skip clear bits
+      m >>= n;
+      y += n;
+      n  = (~m) ? __builtin_ctz(~m) : 32; // Length of run
+      matrix.fillSpan(cursor_x + i, cursor_y + y, 1, n, packed);
+      m  = (n < 32) ? (m >> n) : 0;
+      y += n;
+    }
+  }
+  cursor_x += g->advance;
+  return 1;
+}
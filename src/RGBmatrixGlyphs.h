@@ -0,0 +1,56 @@
+
+#pragma once
+
+#include "RGBmatrixPanel.h"
+
+// Cached text renderer for RGBmatrixPanel.  The first time a character
+// is printed at a given font and size, Adafruit_GFX renders it once into
+// a per-column bit mask.  From then on it's drawn as vertical runs of a
+// pre-encoded color (RGBmatrixPanel::fillSpan()), skipping the font
+// decoding and the per-pixel drawPixel() path entirely.  Use it like the
+// matrix's own print() for scrolling text, clocks and the like:
+//
+//   RGBmatrixGlyphs text(matrix, 32);
+//   text.setCursor(x, 1);
+//   text.setTextColor(color);
+//   text.print("Hello");
+//
+// Text is drawn transparent (no background color), without wrapping.
+// Glyphs taller or wider than 32 pixels are drawn uncached.
+
+class RGBmatrixGlyphs : public Print {
+
+ public:
+
+  RGBmatrixGlyphs(RGBmatrixPanel &panel, uint8_t entries);
+  ~RGBmatrixGlyphs(void);
+
+  void
+    setCursor(int16_t x, int16_t y),
+    setTextColor(uint16_t c),
+    setTextSize(uint8_t s),
+    setFont(uint8_t f),
+    flush(void);   // Empty the cache
+  int16_t
+    getCursorX(void),
+    getCursorY(void);
+
+  size_t write(uint8_t c);
+  using Print::write;
+
+ private:
+
+  struct Glyph {
+    uint32_t *cols;       // One bit per row, bit 0 at top
+    uint8_t   c, size, font, advance;
+  };
+
+  RGBmatrixPanel &matrix;
+  Glyph          *cache;
+  PackedColor     packed;
+  int16_t         cursor_x, cursor_y;
+  uint16_t        color;
+  uint8_t         nEntries, next, textsize, font;
+
+  Glyph *lookup(uint8_t c);
+};
@@ -52,6 +52,22 @@ BSD license, all text above must be included in any redistribution.
   #define pinResetFast(_pin)	PIN_MAP[_pin].gpio_peripheral->BRR = PIN_MAP[_pin].gpio_pin
 #endif
 
+// Set/reset a pin through its port and mask, as cached by selectShift():
+#if defined (STM32F10X_MD) || !defined(PLATFORM_ID)
+  #define portSet(_p)		(_p).port->BSRR = (_p).mask
+  #define portReset(_p)		(_p).port->BRR  = (_p).mask
+#else
+  #define portSet(_p)		(_p).port->BSRRL = (_p).mask
+  #define portReset(_p)		(_p).port->BSRRH = (_p).mask
+#endif
+
+// Lets GCC unroll the constant-length shift loops even at -Os:
+#if defined(__GNUC__) && !defined(__clang__)
+  #define UNROLL __attribute__((optimize("unroll-loops")))
+#else
+  #define UNROLL
+#endif
+
 #if defined (STM32F10X_MD) || !defined(PLATFORM_ID)	//Core
 
  #if defined(FASTER)	// Parital Port writes
@@ -96,6 +112,9 @@ static uint16_t numPanels;
 
 #define nPlanes 4
 
+// LEDs-off time after a row change in SCAN_INTERLEAVED order (usec)
+#define GHOSTBLANK 1
+
 //Define hardware IntervalTimer
 IntervalTimer refreshTimer;
 
@@ -103,31 +122,52 @@ void refreshISR(void);
 
 
 // The fact that the display driver interrupt stuff is tied to the
-// singular Timer1 doesn't really take well to object orientation with
-// multiple RGBmatrixPanel instances.  The solution at present is to
+// singular refreshTimer doesn't really take well to object orientation
+// with multiple RGBmatrixPanel instances.  The solution at present is to
 // allow instances, but only one is active at any given time, via its
-// begin() method.  The implementation is still incomplete in parts;
-// the prior active panel really should be gracefully disabled, and a
-// stop() method should perhaps be added...assuming multiple instances
-// are even an actual need.
-static RGBmatrixPanel *activePanel = NULL;
+// begin() or resume() method.  The prior active panel is stopped at a
+// frame boundary first.  The interrupt handler clears this pointer
+// itself when a stop() request is honored, so it's volatile.
+static RGBmatrixPanel * volatile activePanel = NULL;
 
-// Code common to both the 16x32 and 32x32 constructors:
+// Code common to all constructors:
 void RGBmatrixPanel::init(uint8_t rows, uint8_t a, uint8_t b, uint8_t c,
-  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width) {
+  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width,
+  uint8_t layout, uint8_t *buffer) {
 
   nRows = rows; // Number of multiplexed rows; actual height is 2X this
 
-  // Allocate and initialize matrix buffer:
-  uint32_t buffsize  = width * nRows * 3, // x3 = 3 bytes holds 4 planes "packed"
-      allocsize = (dbuf == true) ? (buffsize * 2) : buffsize;
-  if(NULL == (matrixbuff[0] = (uint8_t *)malloc(allocsize))) return;
-  memset(matrixbuff[0], 0, allocsize);
-  // If not double-buffered, both buffers then point to the same address:
-  matrixbuff[1] = (dbuf == true) ? &matrixbuff[0][buffsize] : matrixbuff[0];
-  
-  // Adjust timing for number of panels (and therefore pixels) wide
-  numPanels = (width -1)/32;
+  // Bytes per column in each scanline: 3 holds the 4 planes "packed",
+  // LAYOUT_UNPACKED gives plane 0 a byte of its own
+  unpacked  = (layout == LAYOUT_UNPACKED);
+  planeRows = unpacked ? nPlanes : nPlanes - 1;
+
+  // Plain 1/2-height scan of a single row of panels, no remapping until
+  // setScanPattern() or setTiling() says so
+  panelHeight = rows * 2;
+  chainPixels = width;
+  tilesX     = 1;
+  tilesY     = 1;
+  tileFlags  = 0;
+  nChains    = 1;
+  scanOrder  = SCAN_ROW_PLANES;
+  mergePlanes = 0;
+  scanBlock  = 8;
+  bandsFlip  = false;
+  rowmap     = NULL;
+  colmap     = NULL;
+  stagebuff  = NULL;
+  stageSlots = 0;
+  stageReady = 0;
+  linebuff   = NULL;
+  commitMask = 0;
+  frameCount = 0;
+  buildMaps();
+
+  // A caller-supplied buffer is taken to fit this initial configuration
+  userbuff = buffer;
+  userSize = buffer ? chainWidth * nRows * planeRows * (dbuf ? 2 : 1) : 0;
+  alloc(dbuf);
 
   // Save pin numbers for use by begin() method later.
   _a     = a;
@@ -140,36 +180,259 @@ void RGBmatrixPanel::init(uint8_t rows, uint8_t a, uint8_t b, uint8_t c,
   plane     = nPlanes - 1;
   row       = nRows   - 1;
   swapflag  = false;
+  stopflag  = false;
   backindex = 0;     // Array index of back buffer
 }
 
+// Allocate and initialize matrix buffer(s), from the heap or, if one was
+// passed to the constructor, in the caller's buffer.  On failure (out of
+// memory, or the caller's buffer is too small for the current geometry),
+// matrixbuff[] is left NULL and false is returned.
+boolean RGBmatrixPanel::alloc(boolean dbuf) {
+  uint32_t buffsize  = chainWidth * nRows * planeRows,
+      allocsize = (dbuf == true) ? (buffsize * 2) : buffsize;
+  doublebuf = dbuf;
+  if(userbuff) matrixbuff[0] = (allocsize <= userSize) ? userbuff : NULL;
+  else         matrixbuff[0] = (uint8_t *)malloc(allocsize);
+  if(NULL == matrixbuff[0]) {
+    matrixbuff[1] = NULL;
+    return false;
+  }
+  memset(matrixbuff[0], 0, allocsize);
+  // If not double-buffered, both buffers then point to the same address:
+  matrixbuff[1] = (dbuf == true) ? &matrixbuff[0][buffsize] : matrixbuff[0];
+  return true;
+}
+
+// Work out the display and shift chain geometry for the current scan
+// pattern and tiling, and the tables mapping display coordinates onto
+// the chain.  Two things can make those differ:
+// - A panel that scans fewer rows than half its height (e.g. 1/8 scan
+//   on 32 rows, or the 1/4 scan outdoor panels) has each address select
+//   several 'bands' of rows per half; their pixels are shifted in as one
+//   longer chain, with columns interleaved in blocks.
+// - Tiling: the chain of panels is folded into tilesY rows of tilesX
+//   panels.  With TILE_SERPENTINE every other row runs right-to-left
+//   with its panels upside down (the short-cable arrangement);
+//   TILE_UPSIDE_DOWN turns every panel over, TILE_BOTTOM_UP starts the
+//   chain on the bottom row.
+// The tables are computed here, once, so drawing only needs two lookups
+// per pixel.  Returns false if the tables couldn't be allocated.
+boolean RGBmatrixPanel::buildMaps(void) {
+  uint16_t x, y, cx, cy, pw, half = panelHeight / 2;
+  uint8_t  band, tx, ty, r;
+  boolean  rev, flip;
+
+  free(rowmap);
+  free(colmap);
+  rowmap = NULL;
+  colmap = NULL;
+  dropStaging();
+
+  nBands     = half / nRows;
+  chainWidth = chainPixels * nBands;
+  chainLen   = chainWidth / nChains;
+  pw         = chainPixels / (tilesX * tilesY);
+
+  // Adjust timing for number of panels (and therefore pixels) wide,
+  // as seen by each of the parallel chains
+  numPanels = (chainLen - 1) / 32;
+  if(numPanels > 3) numPanels = 3;
+
+  // Display size; setRotation() recomputes width()/height() from it
+  matrixWidth  = pw * tilesX;
+  matrixHeight = panelHeight * tilesY;
+  setRotation(rotation);
+
+  if((nBands == 1) && (tilesX == 1) && (tilesY == 1))
+    return true; // Ordinary chain, identity mapping
+
+  rowmap = (uint16_t *)malloc(matrixHeight * sizeof(uint16_t));
+  colmap = (uint16_t *)malloc(tilesY * nBands * matrixWidth *
+    sizeof(uint16_t));
+  if(!rowmap || !colmap) {
+    free(rowmap);
+    free(colmap);
+    rowmap = colmap = NULL;
+    return false;
+  }
+
+  // Row map: low byte is the row in the shift chain's terms (scanline,
+  // plus nRows for the lower half), high byte selects the column map
+  // (one per tile row and band).
+  for(y=0; y<matrixHeight; y++) {
+    ty   = y / panelHeight;
+    r    = (tileFlags & TILE_BOTTOM_UP) ? (tilesY - 1 - ty) : ty;
+    rev  = (tileFlags & TILE_SERPENTINE) && (r & 1);
+    flip = rev ^ ((tileFlags & TILE_UPSIDE_DOWN) != 0);
+    cy   = y % panelHeight;
+    if(flip) cy = panelHeight - 1 - cy;
+    band = (cy % half) / nRows;
+    rowmap[y] = ((uint16_t)(ty * nBands + band) << 8) |
+                ((cy % half) % nRows) | ((cy >= half) ? nRows : 0);
+  }
+
+  // Column maps: position of each panel column along the chain, then
+  // band interleave (each block of scanBlock columns is followed in the
+  // chain by the same columns of the next band).
+  for(ty=0; ty<tilesY; ty++) {
+    r    = (tileFlags & TILE_BOTTOM_UP) ? (tilesY - 1 - ty) : ty;
+    rev  = (tileFlags & TILE_SERPENTINE) && (r & 1);
+    flip = rev ^ ((tileFlags & TILE_UPSIDE_DOWN) != 0);
+    for(x=0; x<matrixWidth; x++) {
+      tx = x / pw;
+      cx = (r * tilesX + (rev ? (tilesX - 1 - tx) : tx)) * pw +
+           (flip ? (pw - 1 - (x % pw)) : (x % pw));
+      for(band=0; band<nBands; band++) {
+        colmap[(ty * nBands + band) * matrixWidth + x] =
+          (cx / scanBlock) * scanBlock * nBands +
+          (bandsFlip ? (nBands - 1 - band) : band) * scanBlock +
+          (cx % scanBlock);
+      }
+    }
+  }
+  return true;
+}
+
+// Clear both buffers, e.g. after the geometry changes and the contents
+// are meaningless.
+void RGBmatrixPanel::clearBuffers(void) {
+  if(matrixbuff[0]) {
+    memset(matrixbuff[0], 0, chainWidth * nRows * planeRows *
+      ((matrixbuff[0] != matrixbuff[1]) ? 2 : 1));
+  }
+}
+
+// Select the panel's row scan pattern: 'scan' is the number of rows
+// driven by the address lines (1/4, 1/8, 1/16 or 1/32 scan), at most
+// half the panel height.  Panels scanning fewer rows interleave the
+// extra bands of rows in blocks of 'block' columns; set 'flip' if the
+// bands appear in the chain bottom-first.  The display is cleared.
+// Returns false if the pattern doesn't fit this panel.
+boolean RGBmatrixPanel::setScanPattern(uint8_t scan, uint8_t block,
+  boolean flip) {
+  boolean running = (activePanel == this);
+
+  if((scan < 2) || (scan > 32) || (scan & (scan - 1)) ||
+     ((panelHeight / 2) % scan) || !block || (chainPixels % block))
+    return false;
+
+  stop();
+  nRows     = scan;
+  scanBlock = block;
+  bandsFlip = flip;
+  if(!buildMaps()) {
+    // Out of memory for tables, go back to plain scanning
+    nRows = panelHeight / 2;
+    buildMaps();
+  }
+  // The buffer size is unchanged (it's always half the pixels)
+  clearBuffers();
+  if(running) resume();
+  return (nRows == scan);
+}
+
+// Arrange the chain of panels (the constructor's width spans all of
+// them) as tilesY rows of tilesX panels.  width() and height() become
+// those of the whole wall; see buildMaps() for the TILE_* flags.  The
+// display is cleared.  Returns false if the chain doesn't divide evenly
+// or there's no memory for the tables (tiling is then left at 1x1).
+boolean RGBmatrixPanel::setTiling(uint8_t tx, uint8_t ty, uint8_t flags) {
+  boolean running = (activePanel == this);
+
+  if(!tx || !ty || (chainPixels % (tx * ty))) return false;
+
+  stop();
+  tilesX    = tx;
+  tilesY    = ty;
+  tileFlags = flags;
+  if(!buildMaps()) {
+    tilesX = tilesY = 1;
+    buildMaps();
+  }
+  clearBuffers();
+  if(running) resume();
+  return (tilesX == tx) && (tilesY == ty);
+}
+
+// Drive the chain as 'chains' (up to 3) separate chains shifted out in
+// parallel, sharing the clock, latch, OE and address lines: chain 0 on
+// the usual R1..B2 pins, the others on the pins given, six per chain in
+// R1, G1, B1, R2, G2, B2 order.  The chain (constructor width) is split
+// evenly, first part on chain 0.  Shift time per row is divided by the
+// number of chains, and the BCM timing is that of the shorter chains.
+// Returns false if the chain doesn't divide evenly, or if there are
+// extra chains but no pins for them.
+boolean RGBmatrixPanel::setParallelChains(uint8_t chains,
+  const uint8_t *pins) {
+  boolean running = (activePanel == this);
+  uint8_t i;
+
+  if((chains < 1) || (chains > 3) || (chainPixels % chains) ||
+     ((chains > 1) && !pins)) return false;
+
+  stop();
+  nChains = chains;
+  for(i=0; i<(chains - 1) * 6; i++) {
+    chainPins[i / 6][i % 6] = pins[i];
+    pinMode(pins[i], OUTPUT); pinResetFast(pins[i]);
+  }
+  buildMaps();
+  if(running) resume();
+  return true;
+}
+
 // Constructor for 16x32 panel:
 RGBmatrixPanel::RGBmatrixPanel(
   uint8_t a, uint8_t b, uint8_t c,
-  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width) :
+  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width,
+  uint8_t layout, uint8_t *buffer) :
   Adafruit_GFX(width, 16) {
 
-  init(8, a, b, c, sclk, latch, oe, dbuf, width);
+  init(8, a, b, c, sclk, latch, oe, dbuf, width, layout, buffer);
 }
 
 // Constructor for 32x32 or 32x64 panel:
 RGBmatrixPanel::RGBmatrixPanel(
   uint8_t a, uint8_t b, uint8_t c, uint8_t d,
-  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width) :
+  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width,
+  uint8_t layout, uint8_t *buffer) :
   Adafruit_GFX(width, 32) {
 
-  init(16, a, b, c, sclk, latch, oe, dbuf, width);
+  init(16, a, b, c, sclk, latch, oe, dbuf, width, layout, buffer);
 
   // Init a few extra 32x32-specific elements:
   _d        = d;
 
 }
 
-void RGBmatrixPanel::begin(void) {
+// Constructor for 64-row panels (adds 'e' pin):
+RGBmatrixPanel::RGBmatrixPanel(
+  uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e,
+  uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width,
+  uint8_t layout, uint8_t *buffer) :
+  Adafruit_GFX(width, 64) {
+
+  init(32, a, b, c, sclk, latch, oe, dbuf, width, layout, buffer);
+
+  _d        = d;
+  _e        = e;
+}
+
+// Set up the pins and start refresh.  Returns false, leaving the display
+// off, if there's no memory for the matrix buffer(s); nothing may be
+// drawn in that case.
+boolean RGBmatrixPanel::begin(uint8_t order) {
+
+  stop(); // If already running, halt cleanly before reinitializing
+
+  scanOrder = order;
+
+  // Buffers are released by end(), or the constructor's allocation
+  // failed; get them back if needed:
+  if((matrixbuff[0] == NULL) && !alloc(doublebuf)) return false;
 
   backindex   = 0;                         // Back buffer
-  buffptr     = matrixbuff[1 - backindex]; // -> front buffer
-  activePanel = this;                      // For interrupt hander
 
   // Enable all comm & address pins as outputs, set default states:
   pinMode(_sclk , OUTPUT); pinResetFast(_sclk);	//Low
@@ -181,6 +444,9 @@ void RGBmatrixPanel::begin(void) {
   if(nRows > 8) {
     pinMode(_d  , OUTPUT); pinResetFast(_d);		//Low
   }
+  if(nRows > 16) {
+    pinMode(_e  , OUTPUT); pinResetFast(_e);		//Low
+  }
 
   pinMode(R1, OUTPUT); pinResetFast(R1);			//Low
   pinMode(G1, OUTPUT); pinResetFast(G1);			//Low
@@ -188,10 +454,82 @@ void RGBmatrixPanel::begin(void) {
   pinMode(R2, OUTPUT); pinResetFast(R2);			//Low
   pinMode(G2, OUTPUT); pinResetFast(G2);			//Low
   pinMode(B2, OUTPUT); pinResetFast(B2);			//Low
-  
+  for(uint8_t i=0; i<(nChains - 1) * 6; i++) {
+    pinMode(chainPins[i / 6][i % 6], OUTPUT);
+    pinResetFast(chainPins[i / 6][i % 6]);
+  }
+
+  resetStats();
+  resume();
+  return true;
+}
+
+// Halt display refresh.  The interrupt handler honors the request at the
+// end of a complete frame (so a stopped panel never shows a partial
+// image), leaves the LEDs blanked and detaches itself; the timer is then
+// shut off here.  Buffer contents are retained and may still be drawn
+// to.  No effect if this panel isn't the one being refreshed.
+void RGBmatrixPanel::stop(void) {
+  if(activePanel != this) return;
+  stopflag = true;                  // Set flag here, then...
+  while(stopflag == true) delay(1); // wait for interrupt to clear it
+  refreshTimer.end();
+}
+
+// Restart display refresh after stop(), from the top of a frame.  If
+// another panel is active, it's stopped first.
+void RGBmatrixPanel::resume(void) {
+  if((activePanel == this) || (matrixbuff[0] == NULL)) return;
+  if(activePanel != NULL) activePanel->stop();
+
+  plane       = nPlanes - 1;               // Next interrupt starts
+  row         = nRows   - 1;               // a fresh frame
+  buffptr     = matrixbuff[1 - backindex]; // -> front buffer
+  lineSrc     = NULL;                      // No line prepared yet
+  selectShift();
+  activePanel = this;                      // For interrupt hander
+
   refreshTimer.begin(refreshISR, 200, uSec);
 }
 
+// Stop refresh and release the matrix buffer(s), e.g. while a sign is
+// blanked for the night.  Nothing may be drawn until begin() is called
+// again, which reallocates (and clears) the buffers.
+void RGBmatrixPanel::end(void) {
+  stop();
+  dropStaging();
+  if(!userbuff) free(matrixbuff[0]);
+  matrixbuff[0] = matrixbuff[1] = NULL;
+}
+
+// Change chain width and/or double-buffering without a reboot.  Refresh
+// is quiesced at a frame boundary, buffers are reallocated (contents are
+// cleared) and refresh resumes if it was running.  The width must suit
+// the scan pattern and parallel chains already set up, as it must for
+// setScanPattern() and setParallelChains(); if not, false is returned
+// and nothing is changed.  Also returns false if the new buffers couldn't
+// be allocated, in which case the panel is left stopped with no buffers
+// (as after end()).
+boolean RGBmatrixPanel::reconfigure(uint16_t width, boolean dbuf) {
+  boolean running = (activePanel == this);
+
+  if(!width || (width % nChains) ||
+     ((nRows < panelHeight / 2) && (width % scanBlock)))
+    return false;
+
+  end();
+
+  // New chain length; keep the tiling if the panels still divide evenly
+  chainPixels = width;
+  if(chainPixels % (tilesX * tilesY)) tilesX = tilesY = 1;
+
+  swapflag  = false;
+  backindex = 0;
+  if(!buildMaps() || !alloc(dbuf)) return false;
+  if(running) resume();
+  return true;
+}
+
 // Original RGBmatrixPanel library used 3/3/3 color.  Later version used
 // 4/4/4.  Then Adafruit_GFX (core library used across all Adafruit
 // display devices now) standardized on 5/6/5.  The matrix still operates
@@ -280,74 +618,249 @@ uint16_t RGBmatrixPanel::ColorHSV(
          (b <<  1) | ( b        >> 3);
 }
 
+// Rotation is resolved once, in setRotation(), which binds the
+// drawPixelRot<> and blitRot<> versions for the new orientation.
 void RGBmatrixPanel::drawPixel(int16_t x, int16_t y, uint16_t c) {
-  uint8_t r, g, b, bit, limit, *ptr;
+  (this->*pixelFunc)(x, y, c);
+}
 
-  if((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
+// width() and height() follow the panel's own dimensions, which can
+// change at runtime, rather than GFX's WIDTH and HEIGHT, fixed at
+// construction.
+void RGBmatrixPanel::setRotation(uint8_t r) {
+  Adafruit_GFX::setRotation(r);
+  _width  = (rotation & 1) ? matrixHeight : matrixWidth;
+  _height = (rotation & 1) ? matrixWidth  : matrixHeight;
 
+  switch(rotation) {
+   case 0:
+    pixelFunc = &RGBmatrixPanel::drawPixelRot<0>;
+    writeFunc = &RGBmatrixPanel::writePixelRot<0>;
+    blitFunc  = &RGBmatrixPanel::blitRot<0>;
+    break;
+   case 1:
+    pixelFunc = &RGBmatrixPanel::drawPixelRot<1>;
+    writeFunc = &RGBmatrixPanel::writePixelRot<1>;
+    blitFunc  = &RGBmatrixPanel::blitRot<1>;
+    break;
+   case 2:
+    pixelFunc = &RGBmatrixPanel::drawPixelRot<2>;
+    writeFunc = &RGBmatrixPanel::writePixelRot<2>;
+    blitFunc  = &RGBmatrixPanel::blitRot<2>;
+    break;
+   default:
+    pixelFunc = &RGBmatrixPanel::drawPixelRot<3>;
+    writeFunc = &RGBmatrixPanel::writePixelRot<3>;
+    blitFunc  = &RGBmatrixPanel::blitRot<3>;
+    break;
+  }
+}
+
+// drawPixel() for rotation ROT: the swaps and flips of unrotate() are
+// fixed at compile time.
+template <uint8_t ROT>
+void RGBmatrixPanel::drawPixelRot(int16_t x, int16_t y, uint16_t c) {
+
+  if((x < 0) || (x >= _width) || (y < 0) || (y >= _height)) return;
+
+  writePixelRot<ROT>(x, y, c);
+}
+
+// writePixel() for rotation ROT, no bounds checking.
+template <uint8_t ROT>
+inline void RGBmatrixPanel::writePixelRot(int16_t x, int16_t y,
+  uint16_t c) {
+  switch(ROT) {
+   case 0:  plot(x,              y,               c); break;
+   case 1:  plot(matrixWidth - 1 - y, x,                     c); break;
+   case 2:  plot(matrixWidth - 1 - x, matrixHeight - 1 - y,  c); break;
+   default: plot(y,                   matrixHeight - 1 - x,  c); break;
+  }
+}
+
+// Draw a batch of pixels, each with its own position and color.  Entries
+// outside the display are skipped.  The rotation is looked up once for
+// the whole batch rather than for each pixel.
+void RGBmatrixPanel::drawPixels(const MatrixPixel *pixels, uint16_t count) {
+  if(pixels == NULL) return;
+
+  switch(rotation) {
+   case 0:  drawPixelsRot<0>(pixels, count); break;
+   case 1:  drawPixelsRot<1>(pixels, count); break;
+   case 2:  drawPixelsRot<2>(pixels, count); break;
+   default: drawPixelsRot<3>(pixels, count); break;
+  }
+}
+
+template <uint8_t ROT>
+void RGBmatrixPanel::drawPixelsRot(const MatrixPixel *pixels,
+  uint16_t count) {
+  uint16_t w = _width, h = _height;
+
+  for(; count--; pixels++) {
+    // Negative coordinates wrap to large unsigned ones: one compare each
+    if(((uint16_t)pixels->x < w) && ((uint16_t)pixels->y < h))
+      writePixelRot<ROT>(pixels->x, pixels->y, pixels->color);
+  }
+}
+
+// Draw a w*h bitmap of 5/6/5 pixels, row-major, at x,y (in the current
+// rotation's coordinates), clipped to the display.  The second form skips
+// pixels matching 'transparent'.  Clipping is done once for the whole
+// bitmap rather than per pixel as with drawPixel().
+void RGBmatrixPanel::drawRGBBitmap(int16_t x, int16_t y,
+  const uint16_t *bitmap, int16_t w, int16_t h) {
+  blit(x, y, bitmap, w, h, false, 0);
+}
+
+void RGBmatrixPanel::drawRGBBitmap(int16_t x, int16_t y,
+  const uint16_t *bitmap, int16_t w, int16_t h, uint16_t transparent) {
+  blit(x, y, bitmap, w, h, true, transparent);
+}
+
+void RGBmatrixPanel::blit(int16_t x, int16_t y, const uint16_t *bitmap,
+  int16_t w, int16_t h, boolean keyed, uint16_t key) {
+  int16_t stride = w;
+
+  if(bitmap == NULL) return;
+  if(x < 0) { bitmap -= x;          w += x; x = 0; }
+  if(y < 0) { bitmap -= y * stride; h += y; y = 0; }
+  if((x + w) > width())  w = width()  - x;
+  if((y + h) > height()) h = height() - y;
+  if((w <= 0) || (h <= 0)) return;
+
+  (this->*blitFunc)(x, y, bitmap, stride, w, h, keyed, key);
+}
+
+// Bitmap drawing for rotation ROT, already clipped.  Each bitmap row
+// starts at a fixed unrotated position and walks one pixel at a time
+// along the panel's x (rotations 0, 2) or y (1, 3) axis.
+template <uint8_t ROT>
+void RGBmatrixPanel::blitRot(int16_t x, int16_t y, const uint16_t *bitmap,
+  int16_t stride, int16_t w, int16_t h, boolean keyed, uint16_t key) {
+  const uint16_t *p;
+  int16_t         i, j, px, py;
+
+  for(j=0; j<h; j++, y++, bitmap += stride) {
+    switch(ROT) {
+     case 0:  px = x;              py = y;              break;
+     case 1:  px = matrixWidth - 1 - y; py = x;                    break;
+     case 2:  px = matrixWidth - 1 - x; py = matrixHeight - 1 - y; break;
+     default: px = y;                   py = matrixHeight - 1 - x; break;
+    }
+    for(i=0, p=bitmap; i<w; i++, p++) {
+      if(!keyed || (*p != key)) plot(px, py, *p);
+      switch(ROT) {
+       case 0:  px++; break;
+       case 1:  py++; break;
+       case 2:  px--; break;
+       default: py--; break;
+      }
+    }
+  }
+}
+
+// Convert coordinates in the current rotation to unrotated panel ones.
+inline void RGBmatrixPanel::unrotate(int16_t &x, int16_t &y) {
   switch(rotation) {
    case 1:
     swap(x, y);
-    x = WIDTH  - 1 - x;
+    x = matrixWidth  - 1 - x;
     break;
    case 2:
-    x = WIDTH  - 1 - x;
-    y = HEIGHT - 1 - y;
+    x = matrixWidth  - 1 - x;
+    y = matrixHeight - 1 - y;
     break;
    case 3:
     swap(x, y);
-    y = HEIGHT - 1 - y;
+    y = matrixHeight - 1 - y;
     break;
   }
+}
+
+// Convert unrotated panel coordinates to shift chain coordinates: x
+// becomes a column within chainWidth, y a scanline (plus nRows for the
+// lower half).  No change for panels scanning half their height.
+inline void RGBmatrixPanel::remap(int16_t &x, int16_t &y) {
+  if(rowmap) {
+    uint16_t m = rowmap[y];
+    x = colmap[(m >> 8) * matrixWidth + x];
+    y = m & 0xFF;
+  }
+}
+
+// Store one pixel at unrotated panel coordinates, no bounds checking.
+void RGBmatrixPanel::plot(int16_t x, int16_t y, uint16_t c) {
+  boolean lower;
+
+  remap(x, y);
+  lower = (y >= nRows);
+  if(lower) y -= nRows;
+  putColor(&matrixbuff[backindex][y * chainWidth * planeRows + x], lower, c);
+}
 
+// Bits of each plane byte (as stored in successive chainWidth-byte runs of a
+// scanline) that belong to pixels in the upper and lower display half, for
+// the packed and unpacked layouts.  See encodeRGB() for how the plane 0
+// bits are tucked in when packed.
+static const uint8_t halfMask[2][2][nPlanes] = {
+  { { 0B00011100, 0B00011101, 0B00011111, 0 },              // Packed upper
+    { 0B11100011, 0B11100010, 0B11100000, 0 } },            // Packed lower
+  { { 0B00011100, 0B00011100, 0B00011100, 0B00011100 },     // Unpacked upper
+    { 0B11100000, 0B11100000, 0B11100000, 0B11100000 } } }; // Unpacked lower
+
+// Each 4-bit channel value spread out one bit per byte: bit p of the
+// value lands in bit 0 of byte p, i.e. the byte for plane p.  Shifted to
+// a channel's bit position and ORed together for R, G and B, this gives
+// a color's bits in all four plane bytes at once.
+static const uint32_t planeSpread[16] = {
+  0x00000000, 0x00000001, 0x00000100, 0x00000101,
+  0x00010000, 0x00010001, 0x00010100, 0x00010101,
+  0x01000000, 0x01000001, 0x01000100, 0x01000101,
+  0x01010000, 0x01010001, 0x01010100, 0x01010101 };
+
+// Bits that 4-bit R, G, B set in each plane byte of a column (byte 0 of
+// the result for the first plane byte, and so on) for the upper or lower
+// half row.  Planes are stored with R, G, B in bits 2-4 for the upper
+// half and 5-7 for the lower, so the six bits can be written straight to
+// the data port.  Unpacked, all four planes have a byte of their own.
+// Packed, the bytes hold planes 1-3 and plane 0 is tucked into the two
+// low bits the others leave free: upper R,G in bits 0,1 of the third
+// byte and B in bit 0 of the second; lower G,B in bits 0,1 of the first
+// and R in bit 1 of the second.
+inline uint32_t RGBmatrixPanel::encodeRGB(uint8_t r, uint8_t g, uint8_t b,
+  boolean lower) {
+  uint32_t v = (planeSpread[r] << 2) | (planeSpread[g] << 3) |
+               (planeSpread[b] << 4);
+
+  if(unpacked) return lower ? (v << 3) : v;
+  v >>= 8; // Planes 1-3 in bytes 0-2
+  if(lower)
+    return (v << 3) | (g & 1) | ((b & 1) << 1) | ((uint32_t)(r & 1) << 9);
+  return v | ((uint32_t)(b & 1) << 8) |
+    ((uint32_t)((r & 1) | ((g & 1) << 1)) << 16);
+}
+
+// Store color 'c' at 'ptr', the first plane byte of a column in some
+// scanline, for the upper or lower half row.
+void RGBmatrixPanel::putColor(uint8_t *ptr, boolean lower, uint16_t c) {
   // Adafruit_GFX uses 16-bit color in 5/6/5 format, while matrix needs
   // 4/4/4.  Pluck out relevant bits while separating into R,G,B:
-  r =  c >> 12;        // RRRRrggggggbbbbb
-  g = (c >>  7) & 0xF; // rrrrrGGGGggbbbbb
-  b = (c >>  1) & 0xF; // rrrrrggggggBBBBb
+  putRGB(ptr, lower,
+     c >> 12,         // RRRRrggggggbbbbb
+    (c >>  7) & 0xF,  // rrrrrGGGGggbbbbb
+    (c >>  1) & 0xF); // rrrrrggggggBBBBb
+}
 
-  // Loop counter stuff
-  bit   = 2;
-  limit = 1 << nPlanes;
-
-  if(y < nRows) {
-    // Data for the upper half of the display is stored in the lower
-    // bits of each byte.
-    ptr = &matrixbuff[backindex][y * WIDTH * (nPlanes - 1) + x]; // Base addr
-    // Plane 0 is a tricky case -- its data is spread about,
-    // stored in least two bits not used by the other planes.
-    ptr[WIDTH*2] &= ~0B00000011;           // Plane 0 R,G mask out in one op
-    if(r & 1) ptr[WIDTH*2] |=  0B00000001; // Plane 0 R: 64 bytes ahead, bit 0
-    if(g & 1) ptr[WIDTH*2] |=  0B00000010; // Plane 0 G: 64 bytes ahead, bit 1
-    if(b & 1) ptr[WIDTH]   |=  0B00000001; // Plane 0 B: 32 bytes ahead, bit 0
-    else      ptr[WIDTH]   &= ~0B00000001; // Plane 0 B unset; mask out
-    // The remaining three image planes are more normal-ish.
-    // Data is stored in the high 6 bits so it can be quickly
-    // copied to the DATAPORT register w/6 output lines.
-    for(; bit < limit; bit <<= 1) {
-      *ptr &= ~0B00011100;            // Mask out R,G,B in one op
-      if(r & bit) *ptr |= 0B00000100; // Plane N R: bit 2
-      if(g & bit) *ptr |= 0B00001000; // Plane N G: bit 3
-      if(b & bit) *ptr |= 0B00010000; // Plane N B: bit 4
-      ptr  += WIDTH;                 // Advance to next bit plane
-    }
-  } else {
-    // Data for the lower half of the display is stored in the upper
-    // bits, except for the plane 0 stuff, using 2 least bits.
-    ptr = &matrixbuff[backindex][(y - nRows) * WIDTH * (nPlanes - 1) + x];
-    *ptr &= ~0B00000011;                  // Plane 0 G,B mask out in one op
-    if(r & 1)  ptr[WIDTH] |=  0B00000010; // Plane 0 R: 32 bytes ahead, bit 1
-    else       ptr[WIDTH] &= ~0B00000010; // Plane 0 R unset; mask out
-    if(g & 1) *ptr        |=  0B00000001; // Plane 0 G: bit 0
-    if(b & 1) *ptr        |=  0B00000010; // Plane 0 B: bit 0
-    for(; bit < limit; bit <<= 1) {
-      *ptr &= ~0B11100000;            // Mask out R,G,B in one op
-      if(r & bit) *ptr |= 0B00100000; // Plane N R: bit 5
-      if(g & bit) *ptr |= 0B01000000; // Plane N G: bit 6
-      if(b & bit) *ptr |= 0B10000000; // Plane N B: bit 7
-      ptr  += WIDTH;                 // Advance to next bit plane
-    }
-  }
+// As putColor(), with 4-bit R, G, B.
+void RGBmatrixPanel::putRGB(uint8_t *ptr, boolean lower,
+  uint8_t r, uint8_t g, uint8_t b) {
+  const uint8_t *mask = halfMask[unpacked][lower];
+  uint32_t       v    = encodeRGB(r, g, b, lower);
+  uint8_t        p;
+
+  for(p=0; p<planeRows; p++, ptr += chainWidth, v >>= 8)
+    *ptr = (*ptr & ~mask[p]) | (uint8_t)v;
 }
 
 void RGBmatrixPanel::fillScreen(uint16_t c) {
@@ -355,10 +868,10 @@ void RGBmatrixPanel::fillScreen(uint16_t c) {
     // For black or white, all bits in frame buffer will be identically
     // set or unset (regardless of weird bit packing), so it's OK to just
     // quickly memset the whole thing:
-    memset(matrixbuff[backindex], c, WIDTH * nRows * 3);
+    memset(matrixbuff[backindex], c, chainWidth * nRows * planeRows);
   } else {
     // Otherwise, need to handle it the long way:
-    Adafruit_GFX::fillScreen(c);
+    fillRect(0, 0, width(), height(), c);
   }
 }
 
@@ -367,6 +880,547 @@ uint8_t *RGBmatrixPanel::backBuffer() {
   return matrixbuff[backindex];
 }
 
+// The back buffer holds scanRows() scanlines of scanLineBytes() each.
+// Each scanline carries one row from the upper half of the display and
+// the matching row from the lower half, in the plane format
+// used by drawPixel() and updateDisplay().
+uint8_t RGBmatrixPanel::scanRows(void) {
+  return nRows;
+}
+
+uint16_t RGBmatrixPanel::scanLineBytes(void) {
+  return chainWidth * planeRows;
+}
+
+// Return address of scanline 'r' in the back buffer
+uint8_t *RGBmatrixPanel::scanLine(uint8_t r) {
+  return &matrixbuff[backindex][r * chainWidth * planeRows];
+}
+
+// Clip a rectangle (in the current rotation's coordinates) to the display
+// and convert to unrotated panel coordinates.  Returns false if nothing
+// remains.
+boolean RGBmatrixPanel::mapRect(
+  int16_t &x, int16_t &y, int16_t &w, int16_t &h) {
+  int16_t t;
+
+  if(x < 0) { w += x; x = 0; }
+  if(y < 0) { h += y; y = 0; }
+  if((x + w) > width())  w = width()  - x;
+  if((y + h) > height()) h = height() - y;
+  if((w <= 0) || (h <= 0)) return false;
+
+  switch(rotation) {
+   case 1:
+    t = x; x = matrixWidth  - y - h; y = t;
+    swap(w, h);
+    break;
+   case 2:
+    x = matrixWidth  - x - w;
+    y = matrixHeight - y - h;
+    break;
+   case 3:
+    t = y; y = matrixHeight - x - w; x = t;
+    swap(w, h);
+    break;
+  }
+  return true;
+}
+
+// Copy a rectangle (in the current rotation's coordinates) from another
+// buffer of the same size and format, e.g. a saved background, into the
+// back buffer.  Each scanline holds two display rows (y and y+scanRows()),
+// so the matching area of the other row comes along as well.
+void RGBmatrixPanel::copyRect(const uint8_t *src,
+  int16_t x, int16_t y, int16_t w, int16_t h) {
+  uint32_t offset;
+  int16_t  px, py, i;
+  uint8_t  p;
+
+  if(!mapRect(x, y, w, h)) return;
+
+  for(h += y; y < h; y++) {
+    if(rowmap) {
+      // Remapped panel: columns aren't contiguous, go pixel by pixel
+      for(i=0; i<w; i++) {
+        px = x + i;
+        py = y;
+        remap(px, py);
+        offset = ((py < nRows) ? py : (py - nRows)) *
+          chainWidth * planeRows + px;
+        for(p=0; p<planeRows; p++, offset += chainWidth)
+          matrixbuff[backindex][offset] = src[offset];
+      }
+      continue;
+    }
+    offset = ((y < nRows) ? y : (y - nRows)) * chainWidth * planeRows + x;
+    for(p=0; p<planeRows; p++, offset += chainWidth)
+      memcpy(&matrixbuff[backindex][offset], &src[offset], w);
+  }
+}
+
+// Offset into a matrix buffer of the first plane byte for unrotated panel
+// coordinates x,y, and whether it's in the lower half row.
+inline uint32_t RGBmatrixPanel::locate(int16_t x, int16_t y,
+  boolean &lower) {
+  remap(x, y);
+  lower = (y >= nRows);
+  return (y - (lower ? nRows : 0)) * chainWidth * planeRows + x;
+}
+
+// Copy a w*h rectangle at sx,sy in another buffer of the same size and
+// format to x,y in the back buffer (all in the current rotation's
+// coordinates), e.g. to scroll or slide saved content.  Unlike the
+// same-position copyRect(), the other half row sharing each scanline is
+// left alone.  Parts falling outside the display at either end are
+// skipped.  Rows stay in one run of masked bytes per plane when the
+// panel is unrotated and not remapped and both rows are in the same
+// half, otherwise pixels are unpacked and moved one at a time.
+void RGBmatrixPanel::copyRect(const uint8_t *src, int16_t sx, int16_t sy,
+  int16_t x, int16_t y, int16_t w, int16_t h) {
+  const uint8_t *mask;
+  uint8_t  *back = matrixbuff[backindex], p, m, r, g, b;
+  uint32_t  so, d;
+  int16_t   i, j, tx, ty;
+  boolean   sl, dl;
+
+  // Clip against both source and destination
+  if(sx < 0) { w += sx; x -= sx; sx = 0; }
+  if(sy < 0) { h += sy; y -= sy; sy = 0; }
+  if(x  < 0) { w += x;  sx -= x; x  = 0; }
+  if(y  < 0) { h += y;  sy -= y; y  = 0; }
+  if((sx + w) > width())  w = width()  - sx;
+  if((x  + w) > width())  w = width()  - x;
+  if((sy + h) > height()) h = height() - sy;
+  if((y  + h) > height()) h = height() - y;
+  if((w <= 0) || (h <= 0)) return;
+
+  for(j=0; j<h; j++) {
+    if(!rotation && !rowmap &&
+       (((sy + j) >= nRows) == ((y + j) >= nRows))) {
+      so   = locate(sx, sy + j, sl);
+      d    = locate(x,  y  + j, dl);
+      mask = halfMask[unpacked][dl];
+      for(p=0; p<planeRows; p++, so += chainWidth, d += chainWidth) {
+        m = mask[p];
+        for(i=0; i<w; i++)
+          back[d + i] = (back[d + i] & ~m) | (src[so + i] & m);
+      }
+      continue;
+    }
+    for(i=0; i<w; i++) {
+      tx = sx + i;
+      ty = sy + j;
+      unrotate(tx, ty);
+      so = locate(tx, ty, sl);
+      tx = x + i;
+      ty = y + j;
+      unrotate(tx, ty);
+      d  = locate(tx, ty, dl);
+      getRGB(&src[so], sl, r, g, b);
+      putRGB(&back[d], dl, r, g, b);
+    }
+  }
+}
+
+// Fill the back buffer with a mix of two whole buffers of the same size
+// and format: 'alpha' 0 gives 'from', 255 gives 'to', in between each
+// channel of each pixel is interpolated.  Works straight through the
+// buffers, independent of rotation or remapping.
+void RGBmatrixPanel::mixBuffers(const uint8_t *from, const uint8_t *to,
+  uint8_t alpha) {
+  uint8_t  *back = matrixbuff[backindex], r0, g0, b0, r1, g1, b1, lower;
+  uint32_t  off;
+  uint16_t  i;
+  uint8_t   line;
+
+  for(line=0; line<nRows; line++) {
+    off = line * chainWidth * planeRows;
+    for(i=0; i<chainWidth; i++, off++) {
+      for(lower=0; lower<2; lower++) {
+        getRGB(&from[off], lower, r0, g0, b0);
+        getRGB(&to[off],   lower, r1, g1, b1);
+        putRGB(&back[off], lower,
+          r0 + (((int16_t)(r1 - r0) * alpha + 128) >> 8),
+          g0 + (((int16_t)(g1 - g0) * alpha + 128) >> 8),
+          b0 + (((int16_t)(b1 - b0) * alpha + 128) >> 8));
+      }
+    }
+  }
+}
+
+// Work out once which bits a color sets in each plane byte, for runs of
+// pixels that all take the same color.
+void RGBmatrixPanel::encodeColor(uint16_t c, PackedColor &pc) {
+  uint32_t u, l;
+  uint8_t  r, g, b, p;
+
+  r =  c >> 12;        // RRRRrggggggbbbbb
+  g = (c >>  7) & 0xF; // rrrrrGGGGggbbbbb
+  b = (c >>  1) & 0xF; // rrrrrggggggBBBBb
+
+  u = encodeRGB(r, g, b, false);
+  l = encodeRGB(r, g, b, true);
+  for(p=0; p<nPlanes; p++, u >>= 8, l >>= 8) {
+    pc.bits[0][p] = u;
+    pc.bits[1][p] = l;
+  }
+}
+
+// Fill a rectangle (in the current rotation's coordinates) with a color
+// from encodeColor().  Each row of the rectangle is three (or, unpacked,
+// four) masked runs of bytes, one per plane byte, with no per-pixel color
+// work.
+void RGBmatrixPanel::fillSpan(int16_t x, int16_t y, int16_t w, int16_t h,
+  const PackedColor &pc) {
+  const uint8_t *mask, *bits;
+  uint8_t       *ptr, m, v, p, lower;
+  int16_t        i, px, py;
+
+  if(!mapRect(x, y, w, h)) return;
+
+  for(h += y; y < h; y++) {
+    if(rowmap) {
+      // Remapped panel: columns aren't contiguous, go pixel by pixel
+      for(i=0; i<w; i++) {
+        px = x + i;
+        py = y;
+        remap(px, py);
+        lower = (py >= nRows);
+        ptr   = &matrixbuff[backindex][(py - (lower ? nRows : 0)) *
+                  chainWidth * planeRows + px];
+        for(p=0; p<planeRows; p++, ptr += chainWidth)
+          *ptr = (*ptr & ~halfMask[unpacked][lower][p]) | pc.bits[lower][p];
+      }
+      continue;
+    }
+    if(y < nRows) {
+      ptr  = &matrixbuff[backindex][y * chainWidth * planeRows + x];
+      mask = halfMask[unpacked][0];
+      bits = pc.bits[0];
+    } else {
+      ptr  = &matrixbuff[backindex][(y - nRows) * chainWidth * planeRows + x];
+      mask = halfMask[unpacked][1];
+      bits = pc.bits[1];
+    }
+    for(p=0; p<planeRows; p++, ptr += chainWidth) {
+      m = ~mask[p];
+      v = bits[p];
+      for(i=0; i<w; i++) ptr[i] = (ptr[i] & m) | v;
+    }
+  }
+}
+
+void RGBmatrixPanel::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+  uint16_t c) {
+  PackedColor pc;
+  encodeColor(c, pc);
+  fillSpan(x, y, w, h, pc);
+}
+
+void RGBmatrixPanel::drawFastVLine(int16_t x, int16_t y, int16_t h,
+  uint16_t c) {
+  fillRect(x, y, 1, h, c);
+}
+
+void RGBmatrixPanel::drawFastHLine(int16_t x, int16_t y, int16_t w,
+  uint16_t c) {
+  fillRect(x, y, w, 1, c);
+}
+
+// Read back the 4-bit R, G, B stored at 'ptr', the first plane byte of a
+// column in some scanline, for the upper or lower half row.
+void RGBmatrixPanel::getRGB(const uint8_t *ptr, boolean lower,
+  uint8_t &r, uint8_t &g, uint8_t &b) {
+  uint8_t p, v, s = lower ? 5 : 2;
+
+  r = g = b = 0;
+  // Planes stored in the same bit positions: all 4 unpacked, 1-3 packed
+  for(p = unpacked ? 0 : 1; p < nPlanes; p++, ptr += chainWidth) {
+    v  = *ptr >> s;
+    r |= ( v       & 1) << p;
+    g |= ((v >> 1) & 1) << p;
+    b |= ((v >> 2) & 1) << p;
+  }
+  if(unpacked) return;
+  ptr -= chainWidth * planeRows;
+  // Plane 0, packed (see encodeRGB())
+  if(lower) {
+    r |= (ptr[chainWidth] >> 1) & 1;
+    g |=  ptr[0]              & 1;
+    b |= (ptr[0]         >> 1) & 1;
+  } else {
+    r |=  ptr[chainWidth*2]       & 1;
+    g |= (ptr[chainWidth*2] >> 1) & 1;
+    b |=  ptr[chainWidth]         & 1;
+  }
+}
+
+// Mix 4-bit R, G, B into the color at 'ptr' by 'alpha' (0-255): each
+// channel moves from its current value towards the new one in proportion.
+inline void RGBmatrixPanel::blendAt(uint8_t *ptr, boolean lower,
+  uint8_t r, uint8_t g, uint8_t b, uint8_t alpha) {
+  uint8_t r0, g0, b0;
+
+  getRGB(ptr, lower, r0, g0, b0);
+  putRGB(ptr, lower,
+    r0 + (((int16_t)(r - r0) * alpha + 128) >> 8),
+    g0 + (((int16_t)(g - g0) * alpha + 128) >> 8),
+    b0 + (((int16_t)(b - b0) * alpha + 128) >> 8));
+}
+
+// Blend a pixel of 5/6/5 color 'c' over the display contents, with
+// 'alpha' from 0 (no change) to 255 (opaque).
+void RGBmatrixPanel::blendPixel(int16_t x, int16_t y, uint16_t c,
+  uint8_t alpha) {
+  boolean lower;
+
+  if((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
+
+  unrotate(x, y);
+  remap(x, y);
+  lower = (y >= nRows);
+  if(lower) y -= nRows;
+  blendAt(&matrixbuff[backindex][y * chainWidth * planeRows + x], lower,
+    c >> 12, (c >> 7) & 0xF, (c >> 1) & 0xF, alpha);
+}
+
+// Blend a rectangle (in the current rotation's coordinates) of color 'c'
+// over the display contents.  The color is split up once and each row
+// is a run along one scanline, unless the panel is remapped.
+void RGBmatrixPanel::blendRect(int16_t x, int16_t y, int16_t w, int16_t h,
+  uint16_t c, uint8_t alpha) {
+  uint8_t  r = c >> 12, g = (c >> 7) & 0xF, b = (c >> 1) & 0xF, *ptr;
+  int16_t  i, px, py;
+  boolean  lower;
+
+  if(!alpha || !mapRect(x, y, w, h)) return;
+
+  for(h += y; y < h; y++) {
+    if(rowmap) {
+      // Remapped panel: columns aren't contiguous, go pixel by pixel
+      for(i=0; i<w; i++) {
+        px = x + i;
+        py = y;
+        remap(px, py);
+        lower = (py >= nRows);
+        blendAt(&matrixbuff[backindex][(py - (lower ? nRows : 0)) *
+          chainWidth * planeRows + px], lower, r, g, b, alpha);
+      }
+      continue;
+    }
+    lower = (y >= nRows);
+    ptr   = &matrixbuff[backindex][(y - (lower ? nRows : 0)) *
+              chainWidth * planeRows + x];
+    for(i=0; i<w; i++) blendAt(&ptr[i], lower, r, g, b, alpha);
+  }
+}
+
+// Blend a w*h bitmap of 5/6/5 pixels (row-major) over the display with
+// its top-left corner at x,y, with overall 'alpha' and, optionally, a
+// per-pixel alpha 'mask' of the same size (scaled by 'alpha').  Rows go
+// along one scanline at a time when the panel is unrotated and not
+// remapped, otherwise pixel by pixel.
+void RGBmatrixPanel::blendBitmap(int16_t x, int16_t y,
+  const uint16_t *bitmap, int16_t w, int16_t h, uint8_t alpha,
+  const uint8_t *mask) {
+  int16_t  i, j, x0, y0, cw, ch;
+  uint16_t c, a;
+  uint8_t  *ptr;
+  boolean  lower;
+
+  if(!alpha) return;
+
+  // Clipped area, in bitmap coordinates
+  x0 = (x < 0) ? -x : 0;
+  y0 = (y < 0) ? -y : 0;
+  cw = ((x + w) > width())  ? (width()  - x) : w;
+  ch = ((y + h) > height()) ? (height() - y) : h;
+
+  for(j=y0; j<ch; j++) {
+    lower = false;
+    ptr   = NULL;
+    if(!rotation && !rowmap) {
+      // First visible column; x alone may be off the left edge
+      lower = ((y + j) >= nRows);
+      ptr   = &matrixbuff[backindex][(y + j - (lower ? nRows : 0)) *
+                chainWidth * planeRows + x + x0];
+    }
+    for(i=x0; i<cw; i++) {
+      c = bitmap[j * w + i];
+      a = mask ? ((mask[j * w + i] * alpha + 255) >> 8) : alpha;
+      if(!a) continue;
+      if(ptr) blendAt(&ptr[i - x0], lower, c >> 12, (c >> 7) & 0xF,
+                (c >> 1) & 0xF, a);
+      else    blendPixel(x + i, y + j, c, a);
+    }
+  }
+}
+
+// Store one full row of 5/6/5 pixels (unrotated panel coordinates,
+// one per column) into the back buffer.  With setStaging(), the row goes
+// into a staging slot and reaches the display at the next safe moment.
+void RGBmatrixPanel::writeRow(int16_t y, const uint16_t *c) {
+  int16_t x, px, py;
+  uint8_t i, *line;
+
+  if((y < 0) || (y >= matrixHeight)) return;
+  if(!stageSlots) {
+    for(x=0; x<matrixWidth; x++) plot(x, y, c[x]);
+    return;
+  }
+
+  // A display row lies within a single scanline (remapped or not), so
+  // stage that and plot into it
+  px = 0;
+  py = y;
+  remap(px, py);
+  i    = claimSlot((py < nRows) ? py : (py - nRows));
+  line = &stagebuff[i * chainWidth * planeRows];
+  for(x=0; x<matrixWidth; x++) {
+    px = x;
+    py = y;
+    remap(px, py);
+    putColor(&line[px], py >= nRows, c[x]);
+  }
+  noInterrupts();
+  stageReady |= 1 << i;
+  interrupts();
+}
+
+// Single-buffer staging: rather than drawing straight into the scanline
+// the refresh interrupt may be in the middle of shifting out (tearing),
+// writeRow() and commitLine() prepare a copy of it in one of 'slots'
+// (up to STAGE_MAX) scanline-sized staging slots.  The interrupt copies
+// finished slots into the display buffer when it's between rows, so each
+// scanline changes all at once, at a cost of 'slots' scanlines of RAM
+// instead of a second buffer.  Only for single-buffered panels (returns
+// false otherwise, or if out of memory); 0 turns it off.  Geometry
+// changes (reconfigure(), setScanPattern()...) turn it off as well.
+boolean RGBmatrixPanel::setStaging(uint8_t slots) {
+  uint8_t *buf;
+
+  if(slots > STAGE_MAX) slots = STAGE_MAX;
+  if(slots && (doublebuf || !matrixbuff[0])) return false;
+
+  while(stageReady) flushStaged(); // Let pending lines in first
+  buf = slots ? (uint8_t *)malloc(slots * chainWidth * planeRows) : NULL;
+  if(slots && !buf) return false;
+
+  noInterrupts();
+  free(stagebuff);
+  stagebuff  = buf;
+  stageSlots = slots;
+  memset((void *)stageRow, STAGE_FREE, sizeof(stageRow));
+  interrupts();
+  return true;
+}
+
+// Discard staging slots and anything pending in them, the refresh line
+// buffer and pending row commits (refresh stopped).
+void RGBmatrixPanel::dropStaging(void) {
+  free(stagebuff);
+  stagebuff  = NULL;
+  stageSlots = 0;
+  stageReady = 0;
+  free(linebuff);
+  linebuff   = NULL;
+  commitMask = 0;
+}
+
+// Have SCAN_ROW_PLANES refresh shift each row out of a private copy of
+// its scanline instead of the display buffer.  All four planes of a row
+// then come from the same snapshot, so drawing into a single-buffered
+// panel can't show up as a row with some planes old and some new.  The
+// copy of the next row is made in the interrupt during the long plane 3
+// period, at a cost of two scanlines of RAM and a scanline copy per row;
+// drawing shows from the next frame.  Only for single-buffered panels
+// (returns false otherwise, or if out of memory); ignored in
+// SCAN_INTERLEAVED order.  Geometry changes turn it off.
+boolean RGBmatrixPanel::setLineBuffer(boolean on) {
+  uint16_t bytes = chainWidth * planeRows;
+  uint8_t *buf, *old;
+
+  if(on && (doublebuf || !matrixbuff[0])) return false;
+  if(on == (linebuff != NULL)) return true;
+  buf = on ? (uint8_t *)malloc(bytes * 2) : NULL;
+  if(on && !buf) return false;
+
+  noInterrupts();
+  old = linebuff;
+  if(old && (buffptr >= old) && (buffptr <= &old[bytes * 2])) {
+    // Mid-row, or just past the end of the row in either half: carry on
+    // from the same place in the display buffer
+    buffptr = matrixbuff[1 - backindex] + row * bytes +
+      (buffptr - &old[lineIndex * bytes]);
+  }
+  linebuff  = buf;
+  lineIndex = 0;
+  lineSrc   = NULL;
+  interrupts();
+  free(old);
+  return true;
+}
+
+// Stage a whole packed scanline 'r' (scanLineBytes() bytes, as found in
+// the matrix buffer).  Without staging, it's copied in directly.
+void RGBmatrixPanel::commitLine(uint8_t r, const uint8_t *src) {
+  uint8_t i;
+
+  if(r >= nRows) return;
+  if(!stageSlots) {
+    memcpy(scanLine(r), src, chainWidth * planeRows);
+    return;
+  }
+  i = claimSlot(r);
+  memcpy(&stagebuff[i * chainWidth * planeRows], src, chainWidth * planeRows);
+  noInterrupts();
+  stageReady |= 1 << i;
+  interrupts();
+}
+
+// Get a staging slot for scanline 'r', to be marked ready in stageReady
+// when filled in: one already pending for that scanline (taken back from
+// the interrupt, which will see it as not ready), else a free one, set
+// up with the scanline's current contents.  If all are pending, waits.
+uint8_t RGBmatrixPanel::claimSlot(uint8_t r) {
+  uint8_t i;
+
+  for(;;) {
+    noInterrupts();
+    for(i=0; i<stageSlots; i++) {
+      if(stageRow[i] == r) {
+        stageReady &= ~(1 << i);
+        interrupts();
+        return i;
+      }
+    }
+    for(i=0; i<stageSlots; i++) {
+      if(stageRow[i] == STAGE_FREE) {
+        stageRow[i] = r;
+        interrupts();
+        memcpy(&stagebuff[i * chainWidth * planeRows], scanLine(r),
+          chainWidth * planeRows);
+        return i;
+      }
+    }
+    interrupts();
+    flushStaged();
+  }
+}
+
+// Wait for the refresh interrupt to take a pending line, or copy them
+// all in here if refresh isn't running.
+void RGBmatrixPanel::flushStaged(void) {
+  if(activePanel == this) {
+    delayMicroseconds(50);
+  } else {
+    noInterrupts();
+    commitStaged(STAGE_FREE);
+    interrupts();
+  }
+}
+
 // For smooth animation -- drawing always takes place in the "back" buffer;
 // this method pushes it to the "front" for display.  Passing "true", the
 // updated display contents are then copied to the new back buffer and can
@@ -380,8 +1434,39 @@ void RGBmatrixPanel::swapBuffers(boolean copy) {
     swapflag = true;                  // Set flag here, then...
     while(swapflag == true) delay(1); // wait for interrupt to clear it
     if(copy == true)
-      memcpy(matrixbuff[backindex], matrixbuff[1-backindex], WIDTH * nRows * 3);
+      memcpy(matrixbuff[backindex], matrixbuff[1-backindex],
+        chainWidth * nRows * planeRows);
+  }
+}
+
+// Show rows y to y+h-1 (in the current rotation's coordinates) of the
+// back buffer without swapping: the scanlines holding them are copied to
+// the front buffer by the refresh interrupt while they aren't being
+// shown, at the next row change (or, in SCAN_INTERLEAVED order, the end
+// of the frame).  For a dashboard where a few rows change, that's
+// a few scanline copies instead of a whole-frame swapBuffers(true), and
+// no tearing.  The back buffer keeps its contents and can be drawn on
+// straight away; anything drawn there before the copy is made goes too.
+// A swapBuffers() in the meantime supersedes pending rows.  Copies at
+// once if refresh isn't running; no effect if not double-buffered.
+void RGBmatrixPanel::commitRows(int16_t y, int16_t h) {
+  uint32_t mask = 0;
+  int16_t  x = 0, w = width(), px, py;
+
+  if((matrixbuff[0] == matrixbuff[1]) || !mapRect(x, y, w, h)) return;
+
+  // Scanlines touched by the (unrotated) rows of the rectangle
+  for(h += y; y < h; y++) {
+    px = x;
+    py = y;
+    remap(px, py);
+    mask |= 1UL << ((py < nRows) ? py : (py - nRows));
   }
+
+  noInterrupts();
+  commitMask |= mask;
+  if(activePanel != this) copyCommitted(nRows);
+  interrupts();
 }
 
 // Dump display contents to the Serial Monitor, adding some formatting to
@@ -391,7 +1476,7 @@ void RGBmatrixPanel::swapBuffers(boolean copy) {
 // back into the display using a pgm_read_byte() loop.
 void RGBmatrixPanel::dumpMatrix(void) {
 
-  uint32_t i, buffsize = WIDTH * nRows * 3;
+  uint32_t i, buffsize = chainWidth * nRows * planeRows;
 
   Serial.print(F("\n\n"
     "static const uint8_t PROGMEM img[] = {\n  "));
@@ -409,11 +1494,80 @@ void RGBmatrixPanel::dumpMatrix(void) {
 }
 
 
+// Write the frame being displayed to 'out' as a one-frame frame file (see
+// RGBmatrixFrames.h), optionally run-length compressed, in two bulk
+// writes: far quicker than dumpMatrix()'s hex listing, e.g. for remote
+// screenshots over TCP.  Compression needs a temporary buffer the size
+// of a frame; without one, or when it doesn't help, the frame goes out
+// raw.  Returns false if 'out' didn't take every byte.
+boolean RGBmatrixPanel::dumpFrame(Print &out, boolean compress) {
+  FrameFileInfo info;
+  FrameInfo     frame;
+  uint8_t       header[FRAMEFILE_HEADER + FRAMEFILE_FRAME],
+               *front = matrixbuff[1 - backindex], *rle = NULL;
+  uint32_t      bytes, n = 0;
+  boolean       ok;
+
+  getFrameInfo(info);
+  bytes = frameBytes(info);
+  if(compress && (NULL != (rle = (uint8_t *)malloc(bytes))))
+    n = frameCompress(front, bytes, rle, bytes - 1);
+
+  frame.compression = n ? FRAMEFILE_RLE : FRAMEFILE_RAW;
+  frame.delay       = 0;
+  frame.size        = n ? n : bytes;
+  frame.checksum    = frameChecksum(front, bytes);
+  frameFileHeader(header, info);
+  frameHeader(&header[FRAMEFILE_HEADER], frame);
+
+  ok = (out.write(header, sizeof(header)) == sizeof(header)) &&
+       (out.write(n ? rle : front, frame.size) == frame.size);
+  free(rle);
+  return ok;
+}
+
+// Describe this panel's buffer format for a frame file (see
+// RGBmatrixFrames.h), with a frame count of 1.
+void RGBmatrixPanel::getFrameInfo(FrameFileInfo &info) {
+  info.version = FRAMEFILE_VERSION;
+  info.layout  = unpacked ? LAYOUT_UNPACKED : LAYOUT_PACKED;
+  info.planes  = nPlanes;
+  info.rows    = nRows;
+  info.columns = chainWidth;
+  info.width   = matrixWidth;
+  info.height  = matrixHeight;
+  info.frames  = 1;
+}
+
+// Load frame 'index' of a frame file (e.g. const data in flash) into the
+// back buffer, and optionally return its delay.  The file must have been
+// made for the same buffer format.  Returns FRAMEFILE_OK or an error; the
+// back buffer is untouched if the file doesn't fit this panel, but may
+// hold a partial frame after a data or checksum error.
+int RGBmatrixPanel::loadFrame(const uint8_t *file, uint32_t len,
+  uint16_t index, uint16_t *delay) {
+  FrameFileInfo  info, mine;
+  FrameInfo      frame;
+  const uint8_t *payload;
+  int            err;
+
+  if((err = frameFileParse(file, len, info)) != FRAMEFILE_OK) return err;
+  getFrameInfo(mine);
+  if((info.layout != mine.layout) || (info.planes != mine.planes) ||
+     (info.rows != mine.rows) || (info.columns != mine.columns))
+    return FRAMEFILE_MISMATCH;
+  if((err = frameFind(file, len, index, frame, payload)) != FRAMEFILE_OK)
+    return err;
+  if(delay) *delay = frame.delay;
+  return frameDecode(frame, payload, matrixbuff[backindex],
+    frameBytes(info));
+}
 
 // -------------------- Interrupt handler stuff --------------------
 void refreshISR(void)
 {
-  activePanel->updateDisplay();   // Call refresh func for active display
+  RGBmatrixPanel *panel = activePanel;
+  if(panel) panel->updateDisplay();   // Call refresh func for active display
 }
 
 // Two constants are used in timing each successive BCM interval.
@@ -461,9 +1615,105 @@ void refreshISR(void)
 // counter variables change between past/present/future tense in mid-
 // function...hopefully tenses are sufficiently commented.
 
+// Plane 0 bits for column i, gathered from the 2 spare bits of the three
+// plane bytes 'w' apart into the same positions as planes 1-3 use:
+#define PLANE0(p, i, w) (uint8_t)(( (p)[i] << 6) | (((p)[(i)+(w)] << 4) & 0x30) | \
+                                  (((p)[(i)+(w)*2] << 2) & 0x0C))
+
+// Bit-bang one column's worth of data (bits 2-7 = R1,G1,B1,R2,G2,B2) on
+// an extra parallel chain's pins.
+static inline void chainOut(const uint8_t *pins, uint8_t bits) {
+  (bits & 0x04) ? pinSetFast(pins[0]) : pinResetFast(pins[0]);	//R1
+  (bits & 0x08) ? pinSetFast(pins[1]) : pinResetFast(pins[1]);	//G1
+  (bits & 0x10) ? pinSetFast(pins[2]) : pinResetFast(pins[2]);	//B1
+  (bits & 0x20) ? pinSetFast(pins[3]) : pinResetFast(pins[3]);	//R2
+  (bits & 0x40) ? pinSetFast(pins[4]) : pinResetFast(pins[4]);	//G2
+  (bits & 0x80) ? pinSetFast(pins[5]) : pinResetFast(pins[5]);	//B2
+}
+
 void RGBmatrixPanel::updateDisplay(void) {
-  uint8_t  i, *ptr;
-  uint16_t duration, pins;
+  uint32_t t = DWT->CYCCNT;
+
+  if(scanOrder == SCAN_INTERLEAVED) refreshInterleaved();
+  else                              while(refreshRowPlanes());
+
+  stats.interrupts++;
+  stats.isrCycles += DWT->CYCCNT - t;
+}
+
+// Set the row address lines:
+inline void RGBmatrixPanel::selectRow(uint8_t r) {
+  (r & 0x1) ? pinSetFast(_a) : pinResetFast(_a);
+  (r & 0x2) ? pinSetFast(_b) : pinResetFast(_b);
+  (r & 0x4) ? pinSetFast(_c) : pinResetFast(_c);
+  if(nRows > 8) {
+    (r & 0x8) ? pinSetFast(_d) : pinResetFast(_d);
+  }
+  if(nRows > 16) {
+    (r & 0x10) ? pinSetFast(_e) : pinResetFast(_e);
+  }
+}
+
+// Copy finished staging slots into the display buffer, other than one
+// for scanline 'busy' (STAGE_FREE for none).
+inline void RGBmatrixPanel::commitStaged(uint8_t busy) {
+  uint8_t i, ready = stageReady;
+
+  for(i=0; ready; i++, ready >>= 1) {
+    if((ready & 1) && (stageRow[i] != busy)) {
+      memcpy(&matrixbuff[0][stageRow[i] * chainWidth * planeRows],
+        &stagebuff[i * chainWidth * planeRows], chainWidth * planeRows);
+      stageReady &= ~(1 << i);
+      stageRow[i] = STAGE_FREE;
+    }
+  }
+}
+
+// Copy scanlines marked by commitRows() from the back buffer to the
+// front, other than scanline 'busy' (nRows for none).
+inline void RGBmatrixPanel::copyCommitted(uint8_t busy) {
+  uint32_t mask  = commitMask;
+  uint16_t bytes = chainWidth * planeRows;
+  uint8_t  r;
+
+  if(busy < nRows) mask &= ~(1UL << busy);
+  commitMask &= ~mask;
+  for(r=0; mask; r++, mask >>= 1) {
+    if(mask & 1)
+      memcpy(&matrixbuff[1 - backindex][r * bytes],
+        &matrixbuff[backindex][r * bytes], bytes);
+  }
+}
+
+// Called as the last row/plane of a frame has been issued: swap buffers
+// if requested, or halt if stop() asked for it.  Returns false if
+// refresh has been halted.
+inline boolean RGBmatrixPanel::frameDone(void) {
+  stats.frames++;
+  frameCount++;
+  if(swapflag == true) {    // Swap front/back buffers if requested
+    backindex  = 1 - backindex;
+    swapflag   = false;
+    commitMask = 0;         // Whole frame shown, row commits moot
+  }
+  if(stopflag == true) {    // Halt at frame boundary if requested:
+    pinResetFast(_latch);   // OE stays high, so LEDs remain off,
+    activePanel = NULL;     // further interrupts are ignored and
+    stopflag    = false;    // stop() is released to end the timer.
+    return false;
+  }
+  return true;
+}
+
+// SCAN_ROW_PLANES order: all four planes of a row, then the next row.
+// With setPlaneMerge(), the shortest planes don't get an interrupt of
+// their own: once the next plane has been shifted out, this busy-waits
+// out the rest of the short plane's period and returns true, to be
+// called again straight away for the next plane.
+inline boolean RGBmatrixPanel::refreshRowPlanes(void) {
+  uint8_t  *ptr;
+  uint32_t duration, shown;
+  boolean  merge;
 
   pinSetFast(_oe);			// Disable LED output during row/plane switchover
   pinSetFast(_latch);		// Latch data loaded during *prior* interrupt
@@ -479,92 +1729,281 @@ void RGBmatrixPanel::updateDisplay(void) {
   // advance lines every time and interleave the planes to reduce
   // vertical scanning artifacts, in practice with this panel it causes
   // a green 'ghosting' effect on black pixels, a much worse artifact.
+  // (SCAN_INTERLEAVED does that anyway, with extra blanking, for panels
+  // where it works out.)
 
   if(++plane >= nPlanes) {      // Advance plane counter.  Maxed out?
     plane = 0;                  // Yes, reset to plane 0, and
     if(++row >= nRows) {        // advance row counter.  Maxed out?
       row     = 0;              // Yes, reset row counter, then...
-      if(swapflag == true) {    // Swap front/back buffers if requested
-        backindex = 1 - backindex;
-        swapflag  = false;
-      }
+      if(!frameDone()) return false;
       buffptr = matrixbuff[1-backindex]; // Reset into front buffer
     }
+    // Between rows: staged lines may go in, except the one starting now
+    if(stageReady) commitStaged(row);
+    if(commitMask) copyCommitted(row);
+    if(linebuff) buffptr = takeLine();
   } else if(plane == 1) {
     // Plane 0 was loaded on prior interrupt invocation and is about to
     // latch now, so update the row address lines before we do that:
-
-    (row & 0x1) ? pinSetFast(_a) : pinResetFast(_a);
-    (row & 0x2) ? pinSetFast(_b) : pinResetFast(_b);
-    (row & 0x4) ? pinSetFast(_c) : pinResetFast(_c);
-    if(nRows > 8) {
-      (row & 0x8) ? pinSetFast(_d) : pinResetFast(_d);
-    }
+    selectRow(row);
   }
 
   // buffptr, being 'volatile' type, doesn't take well to optimization.
   // A local register copy can speed some things up:
   ptr = (uint8_t *)buffptr;
 
+  // Plane now being latched (the one before 'plane') is to be merged?
+  merge = (plane > 0) && (plane <= mergePlanes);
+
   // RESET timer duration
-  refreshTimer.resetPeriod_SIT(duration, uSec);
+  if(!merge) refreshTimer.resetPeriod_SIT(duration, uSec);
 
   pinResetFast(_oe);		// Re-enable output
+  shown = DWT->CYCCNT;
   pinResetFast(_latch);		// Latch down
 
   if(plane > 0) {
+    // Planes 1-3 are shifted out directly, plane 0 has its data packed
+    // into the 2 least bits not used by the other planes.  This works
+    // because the unpacking and output for plane 0 is handled while
+    // plane 3 is being displayed...because binary coded modulation is
+    // used (not PWM), that plane has the longest display interval, so
+    // the extra work fits.
+    (this->*shiftPlanes)(ptr);
+    buffptr += chainWidth;
+  } else {
+    (this->*shiftPlane0)(ptr);
+    if(unpacked) buffptr += chainWidth; // Plane 0 has its own bytes
+    // Plane 3 of the last row is showing, the longest period: time
+    // to copy the next row for the line buffer
+    if(linebuff) prepareLine();
+  }
 
-    // Planes 1-3 must be unpacked and bit-banged
-    for (i=0; i < WIDTH; i++) {
+  if(merge) {
+    duration *= SystemCoreClock / 1000000;
+    while((DWT->CYCCNT - shown) < duration);
+  }
+  return merge;
+}
 
-#if defined (FASTER) && (defined(STM32F10X_MD) || !defined(PLATFORM_ID))
-		pins = (ptr[i] & 0xF8) | ((ptr[i] & 0x04) >> 2);		//Shift R1 to bit 0
-		GPIOB->BSRR = pins;
-		GPIOB->BRR = ~pins & 0xF9;
-		pinSetFast(_sclk);
-		pinResetFast(_sclk);
-#else
-		(ptr[i] & 0x04) ? pinSetFast(R1) : pinResetFast(R1); 	//R1
-		(ptr[i] & 0x08) ? pinSetFast(G1) : pinResetFast(G1);	//G1
-		(ptr[i] & 0x10) ? pinSetFast(B1) : pinResetFast(B1); 	//B1
-		(ptr[i] & 0x20) ? pinSetFast(R2) : pinResetFast(R2);	 //R2
-		(ptr[i] & 0x40) ? pinSetFast(G2) : pinResetFast(G2);	 //G2
-		(ptr[i] & 0x80) ? pinSetFast(B2) : pinResetFast(B2);	 //B2
-		pinSetFast(_sclk);		//hi
-		pinResetFast(_sclk);	//lo
-#endif
-	}
+// Line buffer (see setLineBuffer()): switch to the copy of scanline
+// 'row' made during the last row, or if that's missing or from the
+// wrong buffer (first row after a swap, or refresh just started), copy
+// it now.  Returns its address.
+inline uint8_t *RGBmatrixPanel::takeLine(void) {
+  uint16_t       bytes = chainWidth * planeRows;
+  const uint8_t *src   = matrixbuff[1 - backindex] + row * bytes;
+  uint8_t       *line;
+
+  lineIndex ^= 1;
+  line       = &linebuff[lineIndex * bytes];
+  if(lineSrc != src) memcpy(line, src, bytes);
+  lineSrc    = NULL;
+  return line;
+}
 
-    buffptr += WIDTH;
+// Copy the scanline after 'row' into the other half of the line buffer.
+inline void RGBmatrixPanel::prepareLine(void) {
+  uint16_t bytes = chainWidth * planeRows;
+  uint8_t  r     = (row + 1 < nRows) ? row + 1 : 0;
 
+  lineSrc = matrixbuff[1 - backindex] + r * bytes;
+  memcpy(&linebuff[(lineIndex ^ 1) * bytes], lineSrc, bytes);
+}
+
+// Show the 'planes' shortest bitplanes (0-2) within the interrupt of
+// the plane before them, rather than taking one interrupt each.  Cuts
+// the interrupt rate by up to half in SCAN_ROW_PLANES order, at the cost
+// of busy-waiting whatever part of the short periods isn't spent
+// shifting out data.  Ignored in SCAN_INTERLEAVED order.
+void RGBmatrixPanel::setPlaneMerge(uint8_t planes) {
+  mergePlanes = (planes > nPlanes - 2) ? nPlanes - 2 : planes;
+}
+
+// SCAN_INTERLEAVED order: the row advances on every interrupt, running
+// through all rows for plane 0, then all rows for plane 1 and so on.
+// Long and short display periods are spread evenly over the frame,
+// rather than each row getting its planes back to back.  To keep the
+// previous row's data from ghosting onto the new one, the LEDs stay
+// blanked for GHOSTBLANK microseconds after the address lines change
+// (with the packed layout, for all of plane 0's shifting, see below).
+// Here 'row' and 'plane' on entry are the pair whose data is latched
+// now, then advance to the pair being shifted out for next time.
+inline void RGBmatrixPanel::refreshInterleaved(void) {
+  uint8_t  *ptr;
+  uint8_t  lit;
+  uint16_t duration;
+
+  pinSetFast(_oe);			// Disable LED output during row switchover
+  pinSetFast(_latch);		// Latch data loaded during *prior* interrupt
+  pinResetFast(_sclk);		// Start the clock LOW
+
+  lit      = plane;			// Plane latched, shown until next interrupt
+  duration = dur[numPanels][plane];
+  selectRow(row);
+
+  if(++row >= nRows) {          // Advance row counter.  Maxed out?
+    row = 0;                    // Yes, reset row counter, and
+    if(++plane >= nPlanes) {    // advance plane counter.  Maxed out?
+      plane = 0;                // Yes, frame is done.
+      if(!frameDone()) return;
+      // Every row is mid-frame except between frames, so staged lines
+      // go in here
+      if(stageReady) commitStaged(STAGE_FREE);
+      if(commitMask) copyCommitted(nRows);
+    }
+  }
+
+  // Packed, planes 1-3 are the 1st-3rd chainWidth bytes of the row's
+  // scanline and plane 0 is reassembled from all three; unpacked, each
+  // plane has its own run
+  ptr = matrixbuff[1-backindex] + (row * planeRows +
+    ((unpacked || !plane) ? plane : plane - 1)) * chainWidth;
+
+  if(lit || plane || unpacked) {
+    refreshTimer.resetPeriod_SIT(duration, uSec);
+
+    pinResetFast(_latch);	// Latch down
+    delayMicroseconds(GHOSTBLANK);
+    pinResetFast(_oe);		// Re-enable output
+
+    if(plane > 0) (this->*shiftPlanes)(ptr);
+    else          (this->*shiftPlane0)(ptr);
   } else {
-    // Plane 0 has its data packed into the 2 least bits not
-    // used by the other planes.  This works because the unpacking and
-    // output for plane 0 is handled while plane 3 is being displayed...
-    // because binary coded modulation is used (not PWM), that plane
-    // has the longest display interval, so the extra work fits.
-
-	for(i=0; i < WIDTH; i++) {
-		uint8_t bits = ( ptr[i] << 6) | ((ptr[i+WIDTH] << 4) & 0x30) | ((ptr[i+WIDTH*2] << 2) & 0x0C);
-		
-#if defined (FASTER) && (defined(STM32F10X_MD) || !defined(PLATFORM_ID))
-		pins = (bits & 0xF8) | ((bits & 0x04) >> 2);		//Shift R1 to bit 0
-		GPIOB->BSRR = pins;
-		GPIOB->BRR = ~pins & 0xF9;
+    // Packed plane 0 shifted out while plane 0 is shown: reassembling it
+    // takes longer than that shortest period, which would stretch it.
+    // Shift it out with the LEDs still blanked instead, then show the
+    // latched row for its full period from there, so the period grows
+    // but the time lit stays in proportion.
+    pinResetFast(_latch);	// Latch down
+    (this->*shiftPlane0)(ptr);
+    refreshTimer.resetPeriod_SIT(duration, uSec);
+    pinResetFast(_oe);		// Re-enable output
+  }
+}
+
+// Refresh statistics since the last resetStats() (or begin()): timer
+// interrupts taken, complete frames shown, CPU cycles spent in the
+// interrupt handler and elapsed microseconds.  Refresh rate is then
+// frames * 1000000 / micros, and CPU load isrCycles / (micros *
+// (SystemCoreClock / 1000000)).
+void RGBmatrixPanel::getStats(RefreshStats &s) {
+  noInterrupts();
+  s        = stats;
+  interrupts();
+  s.micros = micros() - statsStart;
+}
+
+// Refresh frames completed since the panel was created, for pacing
+// animation by the refresh (see RGBmatrixScheduler).  Unlike the stats,
+// never reset; wraps after 2^32.
+uint32_t RGBmatrixPanel::refreshCount(void) {
+  return frameCount;
+}
+
+void RGBmatrixPanel::resetStats(void) {
+  // Cycle counter for the interrupt timing:
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
 
-		pinSetFast(_sclk);
-		pinResetFast(_sclk);
+  noInterrupts();
+  memset(&stats, 0, sizeof(stats));
+  statsStart = micros();
+  interrupts();
+}
+
+// Output one column (bits 2-7 = R1,G1,B1,R2,G2,B2) on chain 0's data
+// lines and clock it in.
+inline void RGBmatrixPanel::shiftOut(uint8_t bits) {
+#if defined (FASTER) && (defined(STM32F10X_MD) || !defined(PLATFORM_ID))
+  uint16_t pins = (bits & 0xF8) | ((bits & 0x04) >> 2);	//Shift R1 to bit 0
+  GPIOB->BSRR = pins;
+  GPIOB->BRR = ~pins & 0xF9;
 #else
-		(bits & 0x04) ? pinSetFast(R1) : pinResetFast(R1);		//R1
-		(bits & 0x08) ? pinSetFast(G1) : pinResetFast(G1);		//G1
-		(bits & 0x10) ? pinSetFast(B1) : pinResetFast(B1);		//B1
-		(bits & 0x20) ? pinSetFast(R2) : pinResetFast(R2);		//R2
-		(bits & 0x40) ? pinSetFast(G2) : pinResetFast(G2);		//G2
-		(bits & 0x80) ? pinSetFast(B2) : pinResetFast(B2);		//B2
-		pinSetFast(_sclk);		//hi
-		pinResetFast(_sclk);	//lo
+  (bits & 0x04) ? portSet(dataPort[0]) : portReset(dataPort[0]);	//R1
+  (bits & 0x08) ? portSet(dataPort[1]) : portReset(dataPort[1]);	//G1
+  (bits & 0x10) ? portSet(dataPort[2]) : portReset(dataPort[2]);	//B1
+  (bits & 0x20) ? portSet(dataPort[3]) : portReset(dataPort[3]);	//R2
+  (bits & 0x40) ? portSet(dataPort[4]) : portReset(dataPort[4]);	//G2
+  (bits & 0x80) ? portSet(dataPort[5]) : portReset(dataPort[5]);	//B2
 #endif
+  portSet(clkPort);		//hi
+  portReset(clkPort);	//lo
+}
+
+// Shift loops for one scanline.  LEN is the column count of a single
+// chain when known at compile time, giving the loop a constant trip
+// count and constant plane offsets that the compiler can unroll (much as
+// the original AVR code was unrolled by hand); 0 is the general version,
+// working from chainLen and chainWidth and handling parallel chains,
+// where each clock shifts a column into every chain at once.  The
+// version to use is picked by selectShift() when refresh starts.
+
+template <uint16_t LEN> UNROLL
+void RGBmatrixPanel::shiftRow(const uint8_t *ptr) {
+  const uint16_t len = LEN ? LEN : chainLen;
+
+  for(uint16_t i=0; i < len; i++) {
+    if(!LEN && (nChains > 1)) {
+      chainOut(chainPins[0], ptr[i + len]);
+      if(nChains > 2) chainOut(chainPins[1], ptr[i + len*2]);
+    }
+    shiftOut(ptr[i]);
+  }
+}
+
+template <uint16_t LEN> UNROLL
+void RGBmatrixPanel::shiftRow0(const uint8_t *ptr) {
+  const uint16_t len = LEN ? LEN : chainLen,
+                 w   = LEN ? LEN : chainWidth;
+
+  for(uint16_t i=0; i < len; i++) {
+    if(!LEN && (nChains > 1)) {
+      chainOut(chainPins[0], PLANE0(ptr, i + len, w));
+      if(nChains > 2) chainOut(chainPins[1], PLANE0(ptr, i + len*2, w));
     }
+    shiftOut(PLANE0(ptr, i, w));
+  }
+}
+
+// Bind the shift loops for the current geometry (in LAYOUT_UNPACKED,
+// plane 0 needs no reassembly and goes out like the others) and look up
+// the data and clock pins' ports and masks once, rather than going
+// through PIN_MAP for every bit.  Called with refresh stopped.
+void RGBmatrixPanel::selectShift(void) {
+  static const uint8_t data[6] = { R1, G1, B1, R2, G2, B2 };
+  uint16_t len = (nChains > 1) ? 0 : chainLen;
+  uint8_t  i;
+
+  for(i=0; i<6; i++) {
+    dataPort[i].port = PIN_MAP[data[i]].gpio_peripheral;
+    dataPort[i].mask = PIN_MAP[data[i]].gpio_pin;
+  }
+  clkPort.port = PIN_MAP[_sclk].gpio_peripheral;
+  clkPort.mask = PIN_MAP[_sclk].gpio_pin;
+
+  switch(len) {
+   case 32:
+    shiftPlanes = &RGBmatrixPanel::shiftRow<32>;
+    shiftPlane0 = unpacked ? &RGBmatrixPanel::shiftRow<32> :
+                             &RGBmatrixPanel::shiftRow0<32>;
+    break;
+   case 64:
+    shiftPlanes = &RGBmatrixPanel::shiftRow<64>;
+    shiftPlane0 = unpacked ? &RGBmatrixPanel::shiftRow<64> :
+                             &RGBmatrixPanel::shiftRow0<64>;
+    break;
+   case 128:
+    shiftPlanes = &RGBmatrixPanel::shiftRow<128>;
+    shiftPlane0 = unpacked ? &RGBmatrixPanel::shiftRow<128> :
+                             &RGBmatrixPanel::shiftRow0<128>;
+    break;
+   default:
+    shiftPlanes = &RGBmatrixPanel::shiftRow<0>;
+    shiftPlane0 = unpacked ? &RGBmatrixPanel::shiftRow<0> :
+                             &RGBmatrixPanel::shiftRow0<0>;
+    break;
   }
 }
 
@@ -2,6 +2,63 @@
 #pragma once
 
 #include "Adafruit_mfGFX.h"
+#include "RGBmatrixFrames.h"
+
+// Flags for RGBmatrixPanel::setTiling()
+#define TILE_SERPENTINE  0x01 // Alternate rows run back, panels upside down
+#define TILE_UPSIDE_DOWN 0x02 // All panels mounted upside down
+#define TILE_BOTTOM_UP   0x04 // Chain starts on the bottom row of panels
+
+// Buffer layouts for the RGBmatrixPanel constructors
+#define LAYOUT_PACKED    0 // 3 bytes per column and scanline (default)
+#define LAYOUT_UNPACKED  1 // 4, one per bitplane: more RAM, less work
+
+// Most staging slots for RGBmatrixPanel::setStaging()
+#define STAGE_MAX  4
+#define STAGE_FREE 0xFF
+
+// Refresh orders for RGBmatrixPanel::begin()
+#define SCAN_ROW_PLANES  0 // All bitplanes of a row, then the next row
+#define SCAN_INTERLEAVED 1 // Next row every interrupt, planes in turn
+
+// Refresh statistics from RGBmatrixPanel::getStats()
+typedef struct {
+  uint32_t interrupts, // Refresh interrupts taken
+           frames,     // Complete frames shown
+           isrCycles,  // CPU cycles spent in the interrupt handler
+           micros;     // Time these were collected over
+} RefreshStats;
+
+// Color pre-encoded by RGBmatrixPanel::encodeColor(): the bits it sets in
+// each plane byte of a column, for rows in the upper [0] and lower [1]
+// half of the display, in that panel's buffer layout.  Saves the
+// per-pixel color unpacking when the same color is used for many pixels
+// (fills, text).
+typedef struct {
+  uint8_t bits[2][4];
+} PackedColor;
+
+// One entry of a batch of pixels for RGBmatrixPanel::drawPixels(), in
+// the current rotation's coordinates.
+typedef struct {
+  int16_t  x, y;
+  uint16_t color;
+} MatrixPixel;
+
+// Statically allocated matrix buffer memory, for firmware that wants its
+// footprint fixed at link time rather than taken from the heap: pass
+// 'data' as the RGBmatrixPanel constructor's 'buffer' argument, with
+// matching width, height, double-buffering and layout:
+//
+//   RGBmatrixBuffer<64, 32, true> buff;
+//   RGBmatrixPanel matrix(A, B, C, D, CLK, LAT, OE, true, 64,
+//     LAYOUT_PACKED, buff.data);
+template <uint16_t W, uint8_t H, bool DBUF=false,
+  uint8_t LAYOUT=LAYOUT_PACKED>
+struct RGBmatrixBuffer {
+  uint8_t data[(uint32_t)W * (H / 2) * ((LAYOUT == LAYOUT_UNPACKED) ? 4 : 3) *
+    (DBUF ? 2 : 1)];
+};
 
 class RGBmatrixPanel : public Adafruit_GFX {
 
@@ -9,22 +66,84 @@ class RGBmatrixPanel : public Adafruit_GFX {
 
   // Constructor for 16x32 panel:
   RGBmatrixPanel(uint8_t a, uint8_t b, uint8_t c,
-    uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width=32);
+    uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width=32,
+    uint8_t layout=LAYOUT_PACKED, uint8_t *buffer=NULL);
 
   // Constructor for 32x32 panel (adds 'd' pin):
   RGBmatrixPanel(uint8_t a, uint8_t b, uint8_t c, uint8_t d,
-    uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width=32);
+    uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width=32,
+    uint8_t layout=LAYOUT_PACKED, uint8_t *buffer=NULL);
 
+  // Constructor for 64x64 panel (adds 'e' pin):
+  RGBmatrixPanel(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e,
+    uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf, uint16_t width=64,
+    uint8_t layout=LAYOUT_PACKED, uint8_t *buffer=NULL);
+
+  boolean
+    begin(uint8_t order=SCAN_ROW_PLANES);
   void
-    begin(void),
+    stop(void),
+    resume(void),
+    end(void),
     drawPixel(int16_t x, int16_t y, uint16_t c),
+    setRotation(uint8_t r),
+    drawPixels(const MatrixPixel *pixels, uint16_t count),
+    drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap,
+      int16_t w, int16_t h),
+    drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap,
+      int16_t w, int16_t h, uint16_t transparent),
     fillScreen(uint16_t c),
+    fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c),
+    drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c),
+    drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c),
+    encodeColor(uint16_t c, PackedColor &pc),
+    fillSpan(int16_t x, int16_t y, int16_t w, int16_t h,
+      const PackedColor &pc),
+    blendPixel(int16_t x, int16_t y, uint16_t c, uint8_t alpha),
+    blendRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c,
+      uint8_t alpha),
+    blendBitmap(int16_t x, int16_t y, const uint16_t *bitmap,
+      int16_t w, int16_t h, uint8_t alpha, const uint8_t *mask=NULL),
     updateDisplay(void),
     swapBuffers(boolean),
-    dumpMatrix(void);
+    commitRows(int16_t y, int16_t h=1),
+    writeRow(int16_t y, const uint16_t *c),
+    commitLine(uint8_t r, const uint8_t *src),
+    copyRect(const uint8_t *src, int16_t x, int16_t y, int16_t w, int16_t h),
+    copyRect(const uint8_t *src, int16_t sx, int16_t sy,
+      int16_t x, int16_t y, int16_t w, int16_t h),
+    mixBuffers(const uint8_t *from, const uint8_t *to, uint8_t alpha),
+    dumpMatrix(void),
+    getStats(RefreshStats &s),
+    resetStats(void),
+    setPlaneMerge(uint8_t planes),
+    getFrameInfo(FrameFileInfo &info);
+  int
+    loadFrame(const uint8_t *file, uint32_t len, uint16_t index=0,
+      uint16_t *delay=NULL);
+
+  // drawPixel() without the bounds check, for loops that have already
+  // clipped to width() x height().  Anything outside is undefined.
+  inline void writePixel(int16_t x, int16_t y, uint16_t c) {
+    (this->*writeFunc)(x, y, c);
+  }
+
+  boolean
+    reconfigure(uint16_t width, boolean dbuf),
+    setScanPattern(uint8_t scan, uint8_t block=8, boolean flip=false),
+    setTiling(uint8_t tilesX, uint8_t tilesY, uint8_t flags=0),
+    setParallelChains(uint8_t chains, const uint8_t *pins),
+    setStaging(uint8_t slots),
+    setLineBuffer(boolean on),
+    dumpFrame(Print &out, boolean compress=false);
   uint8_t
-    *backBuffer(void);
+    *backBuffer(void),
+    *scanLine(uint8_t r),
+    scanRows(void);
+  uint32_t
+    refreshCount(void);
   uint16_t
+    scanLineBytes(void),
     Color333(uint8_t r, uint8_t g, uint8_t b),
     Color444(uint8_t r, uint8_t g, uint8_t b),
     Color888(uint8_t r, uint8_t g, uint8_t b),
@@ -34,16 +153,115 @@ class RGBmatrixPanel : public Adafruit_GFX {
  private:
 
   uint8_t         *matrixbuff[2];
-  uint8_t          nRows;
+  uint8_t          nRows, nBands, scanBlock, panelHeight,
+                   tilesX, tilesY, tileFlags, nChains,
+                   planeRows,   // chainWidth-byte runs per scanline
+                   chainPins[2][6]; // Data pins of parallel chains 1, 2
+  uint16_t         chainWidth,  // Columns shifted out per scanline
+                   chainLen,    // ...by each of the parallel chains
+                   chainPixels, // Pixels across the whole chain of panels
+                   matrixWidth, // Unrotated display size, after tiling
+                   matrixHeight;
+  uint16_t        *rowmap,      // Panel to shift chain coordinate tables,
+                  *colmap;      // NULL for plain 1/2-height scan
+  boolean          bandsFlip, unpacked;
   volatile uint8_t backindex;
-  volatile boolean swapflag;
+  volatile boolean swapflag, stopflag;
+  boolean          doublebuf;
+  uint8_t         *userbuff;    // Caller's buffer memory, or NULL for heap
+  uint32_t         userSize;
+
+  // Single-buffer staging (see setStaging()): scanline held in each slot
+  // (STAGE_FREE if none) and a bit per slot ready to be committed
+  uint8_t         *stagebuff, stageSlots;
+  volatile uint8_t stageRow[STAGE_MAX], stageReady;
+
+  uint8_t claimSlot(uint8_t r);
+  void    flushStaged(void),
+          commitStaged(uint8_t busy),
+          dropStaging(void);
+
+  // Refresh line buffer (see setLineBuffer()): two scanline copies, the
+  // one being shown and the next, and the scanline the next was copied
+  // from (NULL if none prepared)
+  uint8_t         *linebuff, lineIndex;
+  const uint8_t   *lineSrc;
+
+  // Double-buffer row commits (see commitRows()): a bit per scanline to
+  // be copied from the back buffer to the front
+  volatile uint32_t commitMask;
+
+  void copyCommitted(uint8_t busy);
+  uint8_t          scanOrder, mergePlanes;
+  RefreshStats     stats;       // micros unused, see statsStart
+  volatile uint32_t frameCount; // Frames shown, never reset
+  uint32_t         statsStart;
 
   // Init/alloc code common to both constructors:
   void init(uint8_t rows, uint8_t a, uint8_t b, uint8_t c,
     uint8_t sclk, uint8_t latch, uint8_t oe, boolean dbuf,
-    uint16_t width);
+    uint16_t width, uint8_t layout, uint8_t *buffer);
+  boolean alloc(boolean dbuf);
+  boolean buildMaps(void);
+  void    clearBuffers(void);
+  void    remap(int16_t &x, int16_t &y);
+  uint32_t locate(int16_t x, int16_t y, boolean &lower);
+  void    unrotate(int16_t &x, int16_t &y),
+          plot(int16_t x, int16_t y, uint16_t c),
+          putColor(uint8_t *ptr, boolean lower, uint16_t c),
+          putRGB(uint8_t *ptr, boolean lower, uint8_t r, uint8_t g,
+            uint8_t b),
+          getRGB(const uint8_t *ptr, boolean lower, uint8_t &r, uint8_t &g,
+            uint8_t &b),
+          blendAt(uint8_t *ptr, boolean lower, uint8_t r, uint8_t g,
+            uint8_t b, uint8_t alpha);
+  uint32_t encodeRGB(uint8_t r, uint8_t g, uint8_t b, boolean lower);
+  boolean mapRect(int16_t &x, int16_t &y, int16_t &w, int16_t &h);
+
+  // Drawing paths specialized for each rotation, bound by setRotation()
+  typedef void (RGBmatrixPanel::*PixelFunc)(int16_t x, int16_t y,
+    uint16_t c);
+  typedef void (RGBmatrixPanel::*BlitFunc)(int16_t x, int16_t y,
+    const uint16_t *bitmap, int16_t stride, int16_t w, int16_t h,
+    boolean keyed, uint16_t key);
+  PixelFunc pixelFunc, writeFunc;
+  BlitFunc  blitFunc;
+
+  void blit(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w,
+    int16_t h, boolean keyed, uint16_t key);
+  template <uint8_t ROT> void drawPixelRot(int16_t x, int16_t y,
+    uint16_t c);
+  template <uint8_t ROT> void writePixelRot(int16_t x, int16_t y,
+    uint16_t c);
+  template <uint8_t ROT> void drawPixelsRot(const MatrixPixel *pixels,
+    uint16_t count);
+  template <uint8_t ROT> void blitRot(int16_t x, int16_t y,
+    const uint16_t *bitmap, int16_t stride, int16_t w, int16_t h,
+    boolean keyed, uint16_t key);
+
+  uint8_t	_sclk, _latch, _oe, _a, _b, _c, _d, _e;
+
+  // Refresh output: port/mask of chain 0's data and clock pins, and the
+  // scanline shift loops specialized for the chain length
+  struct PinPort {
+    GPIO_TypeDef *port;
+    uint16_t      mask;
+  };
+  typedef void (RGBmatrixPanel::*ShiftFunc)(const uint8_t *ptr);
+  PinPort   dataPort[6], clkPort;
+  ShiftFunc shiftPlanes, shiftPlane0;
+
+  void    refreshInterleaved(void),
+          selectRow(uint8_t r);
+  boolean refreshRowPlanes(void),
+          frameDone(void);
+  uint8_t *takeLine(void);
+  void     prepareLine(void);
 
-  uint8_t	_sclk, _latch, _oe, _a, _b, _c, _d;
+  void selectShift(void);
+  void shiftOut(uint8_t bits);
+  template <uint16_t LEN> void shiftRow(const uint8_t *ptr);
+  template <uint16_t LEN> void shiftRow0(const uint8_t *ptr);
 
     //void debugpanel(String message, int value);
 
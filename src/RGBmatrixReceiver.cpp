@@ -0,0 +1,104 @@
+/*
+Stream frame receiver for the RGBmatrixPanel library.  Row data is read
+straight into the panel's back buffer (packed scanlines) or via a single
+row of staging (5/6/5 pixels), so no full-frame copy is ever needed.
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include "RGBmatrixReceiver.h"
+
+RGBmatrixReceiver::RGBmatrixReceiver(RGBmatrixPanel &panel, Stream &source) :
+  matrix(panel), src(source), linebuff(NULL), hcount(0), rowsLeft(0),
+  lineAlloc(0), frames(0), errors(0) {
+}
+
+RGBmatrixReceiver::~RGBmatrixReceiver(void) {
+  free(linebuff);
+}
+
+boolean RGBmatrixReceiver::poll(void) {
+  boolean  done = false;
+  uint8_t *dest;
+  int      n;
+
+  while((n = src.available()) > 0) {
+
+    if(rowsLeft == 0) {
+      // Between chunks: collect header bytes, hunting for the sync
+      // byte first if the stream got out of step.
+      uint8_t c = src.read();
+      if((hcount == 0) && (c != RECEIVE_SYNC)) {
+        errors++;
+        continue;
+      }
+      header[hcount++] = c;
+      if(hcount < sizeof(header)) continue;
+      hcount = 0;
+
+      format   = header[1];
+      row      = header[2];
+      rowsLeft = header[3];
+      pos      = 0;
+      if(format == RECEIVE_PACKED) {
+        rowLimit  = matrix.scanRows();
+        lineBytes = matrix.scanLineBytes();
+      } else if(format == RECEIVE_565) {
+        // Rows are in unrotated panel coordinates
+        boolean swapped = matrix.getRotation() & 1;
+        rowLimit  = swapped ? matrix.width()  : matrix.height();
+        lineBytes = (swapped ? matrix.height() : matrix.width()) * 2;
+        if(lineBytes > lineAlloc) {
+          free(linebuff);
+          lineAlloc = (NULL != (linebuff = (uint8_t *)malloc(lineBytes))) ?
+            lineBytes : 0;
+        }
+        if(linebuff == NULL) rowsLeft = 0;
+      } else {
+        rowsLeft = 0;
+      }
+      if((rowsLeft == 0) || ((row + rowsLeft) > rowLimit)) {
+        rowsLeft = 0; // Discard; payload bytes are skipped until next sync
+        errors++;
+      }
+      continue;
+    }
+
+    // Mid-chunk: read as much of the current row as is on hand.  The
+    // back buffer address is fetched each time as a swap may move it.
+    dest = (format == RECEIVE_PACKED) ? matrix.scanLine(row) : linebuff;
+    if(n > (lineBytes - pos)) n = lineBytes - pos;
+    pos += src.readBytes((char *)&dest[pos], n);
+    if((pos >= lineBytes) && endRow()) done = true;
+  }
+
+  return done;
+}
+
+// Current row has been fully received.  Returns true if it completed
+// a frame.
+boolean RGBmatrixReceiver::endRow(void) {
+  if(format == RECEIVE_565) {
+    // Reassemble little-endian pixels in place; each 16-bit result only
+    // overwrites the two bytes it was made from.
+    uint16_t *pixels = (uint16_t *)linebuff, x, n = lineBytes / 2;
+    for(x=0; x<n; x++)
+      pixels[x] = linebuff[x * 2] | ((uint16_t)linebuff[x * 2 + 1] << 8);
+    matrix.writeRow(row, pixels);
+  }
+  pos = 0;
+  row++;
+  if((--rowsLeft == 0) && (row == rowLimit)) {
+    matrix.swapBuffers(false);
+    frames++;
+    return true;
+  }
+  return false;
+}
+
+uint32_t RGBmatrixReceiver::frameCount(void) {
+  return frames;
+}
+
+uint32_t RGBmatrixReceiver::errorCount(void) {
+  return errors;
+}
@@ -0,0 +1,54 @@
+
+#pragma once
+
+#include "RGBmatrixPanel.h"
+
+// Feeds frames arriving on any Stream (Serial, TCPClient, UDP...) into
+// an RGBmatrixPanel's back buffer, swapping buffers as each frame
+// completes.  Data is sent as a series of row chunks, each with a
+// 4-byte header:
+//
+//   byte 0    RECEIVE_SYNC
+//   byte 1    RECEIVE_PACKED: payload is raw scanlines, exactly as
+//                             held in the matrix buffer (see dumpMatrix())
+//             RECEIVE_565:    payload is 5/6/5 pixels, little-endian,
+//                             in unrotated panel coordinates
+//   byte 2    first scanline (packed) or pixel row (5/6/5)
+//   byte 3    number of scanlines or rows in this chunk
+//   payload   count * scanLineBytes() bytes (packed), or
+//             count * panel width * 2 bytes (5/6/5)
+//
+// A frame is complete when a chunk ends on the last scanline (packed) or
+// last pixel row (5/6/5).  Each frame should cover the whole display, as
+// the buffers are swapped without copying.
+
+#define RECEIVE_SYNC   0xA5
+#define RECEIVE_PACKED 'P'
+#define RECEIVE_565    'C'
+
+class RGBmatrixReceiver {
+
+ public:
+
+  RGBmatrixReceiver(RGBmatrixPanel &panel, Stream &source);
+  ~RGBmatrixReceiver(void);
+
+  // Process whatever bytes are available without blocking.  Returns
+  // true if a frame was completed (and swapped to the display).
+  boolean
+    poll(void);
+  uint32_t
+    frameCount(void),
+    errorCount(void);
+
+ private:
+
+  RGBmatrixPanel &matrix;
+  Stream         &src;
+  uint8_t        *linebuff;  // One row of 5/6/5 pixels being assembled
+  uint8_t         header[4], hcount, format, row, rowsLeft;
+  uint16_t        rowLimit, pos, lineBytes, lineAlloc;
+  uint32_t        frames, errors;
+
+  boolean endRow(void);
+};
@@ -0,0 +1,97 @@
+/*
+Refresh-locked frame scheduler for the RGBmatrixPanel library: animation
+steps counted in refresh frames instead of milliseconds.
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include "RGBmatrixScheduler.h"
+
+// Longest wait for a refresh frame before deciding refresh has stopped
+#define STALL_MS 100
+
+// Refresh frames timed by setPeriod()
+#define TIMED_FRAMES 8
+
+RGBmatrixScheduler::RGBmatrixScheduler(RGBmatrixPanel &panel,
+  uint16_t interval) : matrix(panel), shown(0), dropped(0) {
+  setInterval(interval);
+}
+
+void RGBmatrixScheduler::setInterval(uint16_t interval) {
+  every = interval ? interval : 1;
+  restart();
+}
+
+void RGBmatrixScheduler::restart(void) {
+  next = matrix.refreshCount() + every;
+}
+
+boolean RGBmatrixScheduler::setPeriod(uint16_t ms) {
+  uint32_t now, last = matrix.refreshCount(), first = 0, t = millis(), us = 0;
+  boolean  timing = false;
+
+  // Wait for a frame boundary, then time TIMED_FRAMES frames from it,
+  // giving up as wait() does if refresh stalls
+  for(;;) {
+    if((now = matrix.refreshCount()) != last) {
+      if(!timing) {
+        first  = now;
+        us     = micros();
+        timing = true;
+      } else if((now - first) >= TIMED_FRAMES) {
+        break;
+      }
+      last = now;
+      t    = millis();
+    } else if((millis() - t) > STALL_MS) {
+      return false;
+    }
+    delay(1);
+  }
+  us = (micros() - us) / (now - first); // Per refresh frame
+  setInterval(((uint32_t)ms * 1000 + us / 2) / (us ? us : 1));
+  return true;
+}
+
+// Count a frame as shown at refresh count 'now' (at or after 'next') and
+// schedule the following one, skipping any whole intervals already gone.
+uint16_t RGBmatrixScheduler::advance(uint32_t now) {
+  uint32_t late = (now - next) / every;
+
+  next += (late + 1) * every;
+  shown++;
+  dropped += late;
+  return (late > 0xFFFF) ? 0xFFFF : late;
+}
+
+uint16_t RGBmatrixScheduler::wait(void) {
+  uint32_t now, last = matrix.refreshCount(), t = millis();
+
+  while((int32_t)((now = matrix.refreshCount()) - next) < 0) {
+    if(now != last) {
+      last = now;
+      t    = millis();
+    } else if((millis() - t) > STALL_MS) {
+      restart(); // Not refreshing: don't wait, or count what follows
+      return 0;
+    }
+    delay(1);
+  }
+  return advance(now);
+}
+
+boolean RGBmatrixScheduler::ready(void) {
+  uint32_t now = matrix.refreshCount();
+
+  if((int32_t)(now - next) < 0) return false;
+  advance(now);
+  return true;
+}
+
+uint32_t RGBmatrixScheduler::frames(void) {
+  return shown;
+}
+
+uint32_t RGBmatrixScheduler::skipped(void) {
+  return dropped;
+}
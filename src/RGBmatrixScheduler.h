@@ -0,0 +1,57 @@
+
+#pragma once
+
+#include "RGBmatrixPanel.h"
+
+// Paces animation by the panel's own refresh rather than delay(): a new
+// frame is due every 'interval' completed refresh frames (as counted by
+// the refresh interrupt, RGBmatrixPanel::refreshCount()).  wait() sleeps
+// until the next one is due; if drawing took longer than an interval,
+// the frames missed are skipped and counted rather than rushed through,
+// so motion keeps the same pace:
+//
+//   RGBmatrixScheduler sched(matrix, 15); // ~13 fps at 200Hz refresh
+//   void loop() {
+//     ...draw...
+//     matrix.swapBuffers(false);
+//     sched.wait();
+//   }
+
+class RGBmatrixScheduler {
+
+ public:
+
+  RGBmatrixScheduler(RGBmatrixPanel &panel, uint16_t interval=1);
+
+  void
+    setInterval(uint16_t interval),
+    restart(void);       // Next frame due an interval from now
+  // Set the interval to the number of refresh frames nearest 'ms'
+  // milliseconds, timing the panel's refresh for a few dozen ms to find
+  // out (the frame time depends on panel size, chip and refresh
+  // settings).  Call after begin(), and again if refresh settings
+  // change.  Returns false, leaving the interval alone, if refresh isn't
+  // running.
+  boolean
+    setPeriod(uint16_t ms);
+  // Sleep until the next frame is due.  Returns how many due frames were
+  // missed (and skipped) since the last wait(), 0 if on time.  Returns
+  // at once if refresh has stopped.
+  uint16_t
+    wait(void);
+  // True if the next frame is due, for loops with other work to do; the
+  // frame is then consumed as by wait().
+  boolean
+    ready(void);
+  uint32_t
+    frames(void),        // Frames scheduled so far
+    skipped(void);       // ...and skipped
+
+ private:
+
+  RGBmatrixPanel &matrix;
+  uint32_t        next, shown, dropped;
+  uint16_t        every;
+
+  uint16_t advance(uint32_t now);
+};
@@ -0,0 +1,146 @@
+/*
+Sprite layer for the RGBmatrixPanel library.  Works directly on the
+bit-packed matrix buffers: covered areas are restored from a packed copy
+of the background with row memcpy()s (RGBmatrixPanel::copyRect()).
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include "RGBmatrixSprites.h"
+
+RGBmatrixSprites::RGBmatrixSprites(RGBmatrixPanel &panel, uint8_t maxSprites) :
+  matrix(panel), maxCount(maxSprites) {
+
+  sprites = (Sprite *)calloc(maxSprites, sizeof(Sprite));
+  order   = (uint8_t *)malloc(maxSprites);
+  drawn[0] = (Rect *)malloc(maxSprites * sizeof(Rect));
+  drawn[1] = (Rect *)malloc(maxSprites * sizeof(Rect));
+  bgbuff   = NULL; // Allocated on first captureBackground()
+  bgSize   = 0;
+  drawnBuff[0] = drawnBuff[1] = NULL;
+  drawnCount[0] = drawnCount[1] = 0;
+  if(!sprites || !order || !drawn[0] || !drawn[1]) maxCount = 0;
+}
+
+RGBmatrixSprites::~RGBmatrixSprites(void) {
+  free(sprites);
+  free(order);
+  free(drawn[0]);
+  free(drawn[1]);
+  free(bgbuff);
+}
+
+// Save current back buffer contents as the background.  Call again
+// whenever the background changes, and after the matrix is reconfigured
+// (until then, update() draws nothing).
+void RGBmatrixSprites::captureBackground(void) {
+  uint32_t size = (uint32_t)matrix.scanLineBytes() * matrix.scanRows();
+
+  if(size != bgSize) {
+    free(bgbuff);
+    bgSize = (NULL != (bgbuff = (uint8_t *)malloc(size))) ? size : 0;
+  }
+  if((bgbuff == NULL) || (matrix.backBuffer() == NULL)) return;
+  memcpy(bgbuff, matrix.backBuffer(), size);
+
+  // The back buffer is known to hold just the background; the other
+  // buffer's contents are unknown, so it'll be fully restored once.
+  drawnBuff[0]  = matrix.backBuffer();
+  drawnBuff[1]  = NULL;
+  drawnCount[0] = 0;
+}
+
+int8_t RGBmatrixSprites::add(const uint16_t *bitmap, int16_t w, int16_t h,
+  uint16_t transparent, int8_t z) {
+  for(uint8_t i=0; i<maxCount; i++) {
+    if(!sprites[i].used) {
+      Sprite &s = sprites[i];
+      s.bitmap      = bitmap;
+      s.x           = s.y = 0;
+      s.w           = w;
+      s.h           = h;
+      s.transparent = transparent;
+      s.z           = z;
+      s.used        = true;
+      s.visible     = false;
+      return i;
+    }
+  }
+  return -1;
+}
+
+void RGBmatrixSprites::remove(int8_t id) {
+  if((id >= 0) && (id < maxCount)) sprites[id].used = false;
+}
+
+void RGBmatrixSprites::moveTo(int8_t id, int16_t x, int16_t y) {
+  if((id < 0) || (id >= maxCount)) return;
+  sprites[id].x = x;
+  sprites[id].y = y;
+}
+
+void RGBmatrixSprites::setBitmap(int8_t id, const uint16_t *bitmap,
+  int16_t w, int16_t h) {
+  if((id < 0) || (id >= maxCount)) return;
+  sprites[id].bitmap = bitmap;
+  sprites[id].w      = w;
+  sprites[id].h      = h;
+}
+
+void RGBmatrixSprites::setZ(int8_t id, int8_t z) {
+  if((id >= 0) && (id < maxCount)) sprites[id].z = z;
+}
+
+void RGBmatrixSprites::show(int8_t id, boolean visible) {
+  if((id >= 0) && (id < maxCount)) sprites[id].visible = visible;
+}
+
+// Composite sprites into the back buffer.  Follow with swapBuffers(false)
+// if double-buffered; each buffer keeps its own record of what to erase.
+void RGBmatrixSprites::update(void) {
+  uint8_t *back = matrix.backBuffer(), slot, i, j, n;
+  Rect    *r;
+
+  // Nothing to restore from if the background was captured with other
+  // buffer dimensions
+  if((bgbuff == NULL) || (back == NULL) ||
+     (bgSize != (uint32_t)matrix.scanLineBytes() * matrix.scanRows()))
+    return;
+
+  if(back == drawnBuff[0])      slot = 0;
+  else if(back == drawnBuff[1]) slot = 1;
+  else {
+    // Buffer not seen since the background was captured (or the matrix
+    // was reconfigured): put back the whole background, once.
+    slot = (drawnBuff[0] == NULL) ? 0 : ((drawnBuff[1] == NULL) ? 1 : 0);
+    memcpy(back, bgbuff, bgSize);
+    drawnBuff[slot]  = back;
+    drawnCount[slot] = 0;
+  }
+
+  // Erase sprites as last drawn in this buffer.  All sprites are then
+  // redrawn, so it's fine that restoring also touches the paired row.
+  for(i=0, r=drawn[slot]; i<drawnCount[slot]; i++, r++)
+    matrix.copyRect(bgbuff, r->x, r->y, r->w, r->h);
+
+  // Insertion sort visible sprites by z; the list is short
+  for(i=n=0; i<maxCount; i++) {
+    if(!sprites[i].used || !sprites[i].visible) continue;
+    for(j=n++; (j > 0) && (sprites[order[j-1]].z > sprites[i].z); j--)
+      order[j] = order[j-1];
+    order[j] = i;
+  }
+
+  for(i=0, r=drawn[slot]; i<n; i++, r++) {
+    Sprite &s = sprites[order[i]];
+    draw(s);
+    r->x = s.x;
+    r->y = s.y;
+    r->w = s.w;
+    r->h = s.h;
+  }
+  drawnCount[slot] = n;
+}
+
+void RGBmatrixSprites::draw(const Sprite &s) {
+  matrix.drawRGBBitmap(s.x, s.y, s.bitmap, s.w, s.h, s.transparent);
+}
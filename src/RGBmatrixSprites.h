@@ -0,0 +1,59 @@
+
+#pragma once
+
+#include "RGBmatrixPanel.h"
+
+// Sprite layer for RGBmatrixPanel.  A background image is captured once
+// from the back buffer; each update() then restores only the areas the
+// sprites covered in that buffer last time and draws the sprites over
+// it in z order, so moving a few objects costs in proportion to their
+// size rather than the size of the display.  Anything else drawn to
+// the matrix should go into the background (followed by another
+// captureBackground()), as update() owns the back buffer contents.
+
+class RGBmatrixSprites {
+
+ public:
+
+  RGBmatrixSprites(RGBmatrixPanel &panel, uint8_t maxSprites);
+  ~RGBmatrixSprites(void);
+
+  // Returns a sprite handle, or -1 if the table is full.  The bitmap is
+  // w*h 5/6/5 pixels, row-major; pixels matching 'transparent' aren't
+  // drawn.  Higher z draws on top.  Sprites start out hidden at 0,0.
+  int8_t
+    add(const uint16_t *bitmap, int16_t w, int16_t h,
+      uint16_t transparent, int8_t z=0);
+  void
+    captureBackground(void),
+    remove(int8_t id),
+    moveTo(int8_t id, int16_t x, int16_t y),
+    setBitmap(int8_t id, const uint16_t *bitmap, int16_t w, int16_t h),
+    setZ(int8_t id, int8_t z),
+    show(int8_t id, boolean visible),
+    update(void);
+
+ private:
+
+  struct Sprite {
+    const uint16_t *bitmap;
+    int16_t         x, y, w, h;
+    uint16_t        transparent;
+    int8_t          z;
+    boolean         used, visible;
+  };
+  struct Rect {
+    int16_t x, y, w, h;
+  };
+
+  RGBmatrixPanel &matrix;
+  Sprite         *sprites;
+  uint8_t        *bgbuff,     // Captured background, same format as matrix
+                 *order,      // Sprite indices sorted by z
+                 *drawnBuff[2];
+  Rect           *drawn[2];   // Areas covered, per matrix buffer
+  uint8_t         maxCount, drawnCount[2];
+  uint32_t        bgSize;     // Bytes in bgbuff
+
+  void draw(const Sprite &s);
+};
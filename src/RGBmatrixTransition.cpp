@@ -0,0 +1,93 @@
+/*
+Frame transitions for the RGBmatrixPanel library.  Intermediate frames
+are built from row-wise operations on the packed matrix buffers: plane
+row copies for wipes and slides, per-channel interpolation for fades.
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include "RGBmatrixTransition.h"
+
+RGBmatrixTransition::RGBmatrixTransition(RGBmatrixPanel &panel) :
+  matrix(panel), src(NULL), dst(NULL), kind(TRANSITION_FADE), count(0),
+  total(0) {
+}
+
+void RGBmatrixTransition::start(const uint8_t *from, const uint8_t *to,
+  uint8_t type, uint16_t steps) {
+  src   = from;
+  dst   = to;
+  kind  = type;
+  total = steps ? steps : 1;
+  count = 0;
+}
+
+boolean RGBmatrixTransition::busy(void) {
+  return count < total;
+}
+
+boolean RGBmatrixTransition::step(void) {
+  uint32_t size;
+
+  if(!busy()) return false;
+
+  if(++count < total) {
+    render(count);
+    matrix.swapBuffers(false);
+    return true;
+  }
+
+  // Last step: the new frame exactly, in both buffers, so drawing can
+  // carry on from it
+  size = (uint32_t)matrix.scanLineBytes() * matrix.scanRows();
+  memcpy(matrix.backBuffer(), dst, size);
+  matrix.swapBuffers(false);
+  memcpy(matrix.backBuffer(), dst, size);
+  return false;
+}
+
+// Draw frame 'n' of 'total' into the back buffer.  All copies are the
+// offset kind of copyRect(), which leaves the other half row of each
+// scanline alone, as that may belong to the other frame.
+void RGBmatrixTransition::render(uint16_t n) {
+  int16_t w = matrix.width(), h = matrix.height(),
+          e = ((uint32_t)w * n) / total,   // Progress across...
+          f = ((uint32_t)h * n) / total;   // ...and down
+
+  switch(kind) {
+   case TRANSITION_WIPE_LEFT:
+    matrix.copyRect(src, 0, 0, 0, 0, w - e, h);
+    matrix.copyRect(dst, w - e, 0, w - e, 0, e, h);
+    break;
+   case TRANSITION_WIPE_RIGHT:
+    matrix.copyRect(dst, 0, 0, 0, 0, e, h);
+    matrix.copyRect(src, e, 0, e, 0, w - e, h);
+    break;
+   case TRANSITION_WIPE_UP:
+    matrix.copyRect(src, 0, 0, 0, 0, w, h - f);
+    matrix.copyRect(dst, 0, h - f, 0, h - f, w, f);
+    break;
+   case TRANSITION_WIPE_DOWN:
+    matrix.copyRect(dst, 0, 0, 0, 0, w, f);
+    matrix.copyRect(src, 0, f, 0, f, w, h - f);
+    break;
+   case TRANSITION_SLIDE_LEFT:
+    matrix.copyRect(src, e, 0, 0, 0, w - e, h);
+    matrix.copyRect(dst, 0, 0, w - e, 0, e, h);
+    break;
+   case TRANSITION_SLIDE_RIGHT:
+    matrix.copyRect(src, 0, 0, e, 0, w - e, h);
+    matrix.copyRect(dst, w - e, 0, 0, 0, e, h);
+    break;
+   case TRANSITION_SLIDE_UP:
+    matrix.copyRect(src, 0, f, 0, 0, w, h - f);
+    matrix.copyRect(dst, 0, 0, 0, h - f, w, f);
+    break;
+   case TRANSITION_SLIDE_DOWN:
+    matrix.copyRect(src, 0, 0, 0, f, w, h - f);
+    matrix.copyRect(dst, 0, h - f, 0, 0, w, f);
+    break;
+   default:
+    matrix.mixBuffers(src, dst, ((uint32_t)n * 255) / total);
+    break;
+  }
+}
@@ -0,0 +1,55 @@
+
+#pragma once
+
+#include "RGBmatrixPanel.h"
+
+// Frame transitions for RGBmatrixPanel.  Given two complete frames in the
+// matrix buffer format (e.g. copies of backBuffer(), scanLineBytes() *
+// scanRows() bytes each), each step() renders the next in-between frame
+// into the back buffer and swaps it to the display, so the pace is one
+// step per refresh frame.  Wipes and slides are made of row copies
+// (RGBmatrixPanel::copyRect()), fades of per-channel interpolation
+// (RGBmatrixPanel::mixBuffers()).  Meant for double-buffered panels;
+// single-buffered ones don't wait for the swap, so the caller should
+// pace the steps and will see some tearing.
+//
+//   RGBmatrixTransition fx(matrix);
+//   fx.start(page1, page2, TRANSITION_SLIDE_LEFT, 32);
+//   while(fx.step());
+
+#define TRANSITION_FADE        0 // Crossfade
+#define TRANSITION_WIPE_LEFT   1 // Edge moves leftwards, revealing new frame
+#define TRANSITION_WIPE_RIGHT  2
+#define TRANSITION_WIPE_UP     3
+#define TRANSITION_WIPE_DOWN   4
+#define TRANSITION_SLIDE_LEFT  5 // Old frame pushed out left by the new one
+#define TRANSITION_SLIDE_RIGHT 6
+#define TRANSITION_SLIDE_UP    7
+#define TRANSITION_SLIDE_DOWN  8
+
+class RGBmatrixTransition {
+
+ public:
+
+  RGBmatrixTransition(RGBmatrixPanel &panel);
+
+  // Set up a transition over 'steps' frames.  Both frames must stay
+  // valid until it's done.
+  void
+    start(const uint8_t *from, const uint8_t *to, uint8_t type,
+      uint16_t steps);
+  // Show the next frame.  Returns false once the transition is complete
+  // (the last call having left 'to' in both buffers).
+  boolean
+    step(void),
+    busy(void);
+
+ private:
+
+  RGBmatrixPanel &matrix;
+  const uint8_t  *src, *dst;
+  uint8_t         kind;
+  uint16_t        count, total;
+
+  void render(uint16_t n);
+};
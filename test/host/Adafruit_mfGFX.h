@@ -0,0 +1,44 @@
+// Host stand-in for Adafruit_mfGFX: the members the library relies on,
+// with lines and rectangles drawn a pixel at a time.  No fonts.
+#pragma once
+
+#include "application.h"
+
+#define swap(a, b) { int16_t t = a; a = b; b = t; }
+
+class Adafruit_GFX : public Print {
+
+ public:
+
+  Adafruit_GFX(int16_t w, int16_t h);
+  virtual ~Adafruit_GFX() {}
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+  virtual void
+    drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color),
+    drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color),
+    drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color),
+    drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
+    fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
+    fillScreen(uint16_t color),
+    invertDisplay(boolean i);
+  void
+    setCursor(int16_t x, int16_t y),
+    setTextColor(uint16_t c),
+    setTextColor(uint16_t c, uint16_t bg),
+    setTextSize(uint8_t s),
+    setTextWrap(boolean w),
+    setRotation(uint8_t r),
+    setFont(uint8_t f);
+  virtual size_t write(uint8_t c);
+  int16_t height(void), width(void);
+  uint8_t getRotation(void);
+
+ protected:
+
+  const int16_t WIDTH, HEIGHT;
+  int16_t  _width, _height, cursor_x, cursor_y;
+  uint16_t textcolor, textbgcolor;
+  uint8_t  textsize, rotation, font;
+  boolean  wrap;
+};
@@ -0,0 +1,16 @@
+// Host stand-in for SparkIntervalTimer: the refresh interrupt is called
+// from delay() instead of a hardware timer (see host.cpp).
+#pragma once
+
+#include "application.h"
+
+enum { uSec, hmSec };
+enum { INT_DISABLE, INT_ENABLE };
+
+class IntervalTimer {
+ public:
+  bool begin(void (*isr)(void), uint16_t period, bool scale);
+  void end(void);
+  void resetPeriod_SIT(uint16_t period, bool scale);
+  void interrupt_SIT(bool action);
+};
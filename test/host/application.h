@@ -0,0 +1,81 @@
+// Host stand-in for the parts of the Particle firmware API the library
+// uses, so its sources build and run on a PC for testing.  GPIO writes
+// land in plain variables; see host.cpp for the timer and clock model.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool     boolean;
+typedef uint8_t  byte;
+typedef uint16_t pin_t;
+
+#define OUTPUT 1
+#define HEX    16
+#define F(x)   x
+
+enum { D0, D1, D2, D3, D4, D5, D6, D7,
+       A0, A1, A2, A3, A4, A5, A6, A7, RX, TX, WKP, DAC, NUM_PINS };
+
+typedef struct {
+  volatile uint32_t BSRRL, BSRRH, BSRR, BRR, ODR;
+} GPIO_TypeDef;
+
+typedef struct {
+  GPIO_TypeDef *gpio_peripheral;
+  uint16_t      gpio_pin;
+} STM32_Pin_Info;
+
+extern STM32_Pin_Info *PIN_MAP;
+
+inline void pinSetFast(pin_t p) {
+  PIN_MAP[p].gpio_peripheral->BSRRL = PIN_MAP[p].gpio_pin;
+}
+inline void pinResetFast(pin_t p) {
+  PIN_MAP[p].gpio_peripheral->BSRRH = PIN_MAP[p].gpio_pin;
+}
+
+void          pinMode(uint16_t pin, int mode);
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+unsigned long millis(void);
+unsigned long micros(void);
+void          noInterrupts(void);
+void          interrupts(void);
+
+typedef struct { volatile uint32_t CTRL, CYCCNT; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+extern DWT_Type       *DWT;
+extern CoreDebug_Type *CoreDebug;
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk     1UL
+#define SystemCoreClock            120000000UL
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t print(const char *s);
+  size_t print(int n, int base=10);
+  size_t println(const char *s);
+};
+
+class Stream : public Print {
+ public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+  size_t readBytes(char *buffer, size_t length);
+};
+
+class USBSerial : public Stream {
+ public:
+  int    available(void) { return 0; }
+  int    read(void)      { return -1; }
+  int    peek(void)      { return -1; }
+  size_t write(uint8_t)  { return 1; }
+};
+extern USBSerial Serial;
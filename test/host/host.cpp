@@ -0,0 +1,139 @@
+// Host side of the test stand-ins: GPIO ports and pin map, a simulated
+// clock, and the refresh timer.  The timer's interrupt handler is called
+// from delay() (which is how the library waits on the interrupt, e.g. in
+// swapBuffers()), once per timer period of simulated time.
+
+#include "Adafruit_mfGFX.h"
+#include "SparkIntervalTimer.h"
+
+static GPIO_TypeDef   ports[4];
+static STM32_Pin_Info pinMap[NUM_PINS];
+static DWT_Type       dwt;
+static CoreDebug_Type coreDebug;
+
+STM32_Pin_Info *PIN_MAP   = pinMap;
+DWT_Type       *DWT       = &dwt;
+CoreDebug_Type *CoreDebug = &coreDebug;
+USBSerial       Serial;
+
+static struct PinMapInit {
+  PinMapInit() {
+    for(int p=0; p<NUM_PINS; p++) {
+      pinMap[p].gpio_peripheral = &ports[p / 8];
+      pinMap[p].gpio_pin        = 1 << (p % 8);
+    }
+  }
+} pinMapInit;
+
+static void     (*timerISR)(void) = NULL;
+static uint16_t   timerPeriod     = 0;
+static unsigned long now          = 0; // Simulated time, microseconds
+
+void pinMode(uint16_t, int) { }
+void noInterrupts(void)     { }
+void interrupts(void)       { }
+
+void delay(unsigned long ms) {
+  unsigned long end = now + ms * 1000;
+  while(timerISR && timerPeriod && ((now + timerPeriod) <= end)) {
+    now += timerPeriod;
+    timerISR();
+  }
+  now = end;
+}
+
+void delayMicroseconds(unsigned int us) { now += us; }
+unsigned long millis(void)              { return now / 1000; }
+unsigned long micros(void)              { return now; }
+
+bool IntervalTimer::begin(void (*isr)(void), uint16_t period, bool) {
+  timerISR    = isr;
+  timerPeriod = period;
+  return true;
+}
+void IntervalTimer::end(void) { timerISR = NULL; }
+void IntervalTimer::resetPeriod_SIT(uint16_t period, bool) {
+  timerPeriod = period;
+}
+void IntervalTimer::interrupt_SIT(bool) { }
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for(size_t i=0; i<size; i++) write(buffer[i]);
+  return size;
+}
+size_t Print::print(const char *s) {
+  return write((const uint8_t *)s, strlen(s));
+}
+size_t Print::print(int, int)            { return 0; }
+size_t Print::println(const char *s)     { return print(s) + print("\n"); }
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t i;
+  int    c;
+  for(i=0; (i<length) && ((c = read()) >= 0); i++) buffer[i] = c;
+  return i;
+}
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {
+  _width    = w;
+  _height   = h;
+  cursor_x  = cursor_y = 0;
+  textcolor = textbgcolor = 0xFFFF;
+  textsize  = 1;
+  rotation  = 0;
+  font      = 0;
+  wrap      = true;
+}
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+  uint16_t color) {
+  int16_t dx = abs(x1 - x0), dy = abs(y1 - y0), n = (dx > dy) ? dx : dy, i;
+  for(i=0; i<=n; i++) {
+    drawPixel(x0 + (n ? (x1 - x0) * i / n : 0),
+              y0 + (n ? (y1 - y0) * i / n : 0), color);
+  }
+}
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h,
+  uint16_t color) {
+  drawLine(x, y, x, y + h - 1, color);
+}
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w,
+  uint16_t color) {
+  drawLine(x, y, x + w - 1, y, color);
+}
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
+  uint16_t color) {
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+  uint16_t color) {
+  for(int16_t i=x; i<x+w; i++) drawFastVLine(i, y, h, color);
+}
+void Adafruit_GFX::fillScreen(uint16_t color) {
+  fillRect(0, 0, _width, _height, color);
+}
+void Adafruit_GFX::invertDisplay(boolean) { }
+void Adafruit_GFX::setCursor(int16_t x, int16_t y) {
+  cursor_x = x;
+  cursor_y = y;
+}
+void Adafruit_GFX::setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+void Adafruit_GFX::setTextColor(uint16_t c, uint16_t bg) {
+  textcolor   = c;
+  textbgcolor = bg;
+}
+void Adafruit_GFX::setTextSize(uint8_t s) { textsize = (s > 0) ? s : 1; }
+void Adafruit_GFX::setTextWrap(boolean w) { wrap = w; }
+void Adafruit_GFX::setRotation(uint8_t r) {
+  rotation = r & 3;
+  _width   = (rotation & 1) ? HEIGHT : WIDTH;
+  _height  = (rotation & 1) ? WIDTH  : HEIGHT;
+}
+void Adafruit_GFX::setFont(uint8_t f) { font = f; }
+size_t Adafruit_GFX::write(uint8_t) { return 1; }
+int16_t Adafruit_GFX::width(void)   { return _width; }
+int16_t Adafruit_GFX::height(void)  { return _height; }
+uint8_t Adafruit_GFX::getRotation(void) { return rotation; }
@@ -0,0 +1,82 @@
+/*
+Host test for RGBmatrixPanel::setLineBuffer(): the line buffer is turned
+on and off again after every possible number of refresh interrupts, so
+it's freed with the refresh mid-row, at the end of a row staged in
+either half, and between frames.  Refresh must then carry on from the
+display buffer, never from the freed copy.  Uses the Particle stand-ins
+in this directory; the refresh interrupt is called directly, one at a
+time.
+
+Build and run (from this directory), with AddressSanitizer to catch any
+read of the freed line buffer:
+
+  g++ -std=gnu++11 -Wall -g -fsanitize=address -DPLATFORM_ID=6 \
+    -DSTM32F2XX -I. -I../../src -o linebuffer_test linebuffer_test.cpp \
+    host.cpp ../../src/RGBmatrixPanel.cpp ../../src/RGBmatrixFrames.cpp \
+    && ./linebuffer_test
+
+Prints each failed check and exits non-zero if there were any.
+*/
+
+#include <stdio.h>
+#include "RGBmatrixPanel.h"
+
+void refreshISR(void); // The panel's timer interrupt handler
+
+static int failures = 0;
+
+#define CHECK(cond) do { if(!(cond)) { \
+  printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+} while(0)
+
+// Interrupts in a whole frame: one per plane per scanline
+static int frameInterrupts(RGBmatrixPanel &m) {
+  return m.scanRows() * 4;
+}
+
+static void run(int interrupts) {
+  while(interrupts-- > 0) refreshISR();
+}
+
+static void toggleEverywhere(RGBmatrixPanel &m) {
+  uint32_t frames;
+  int      n, k;
+
+  n = frameInterrupts(m) * 2;
+  for(k=0; k<=n; k++) {
+    CHECK(m.setLineBuffer(true));
+    run(k);
+    CHECK(m.setLineBuffer(false));
+    frames = m.refreshCount();
+    run(frameInterrupts(m) + 1);
+    CHECK(m.refreshCount() > frames);
+  }
+}
+
+int main(void) {
+  RGBmatrixPanel packed(A0, A1, A2, D6, TX, D7, false),
+                 unpacked(A0, A1, A2, A3, D6, TX, D7, false, 64,
+                   LAYOUT_UNPACKED);
+  int16_t        x, y;
+
+  // Some content, so whatever is shifted out isn't all zeros
+  CHECK(packed.begin());
+  for(y=0; y<packed.height(); y++)
+    for(x=0; x<packed.width(); x++) packed.drawPixel(x, y, x * 997 + y);
+  toggleEverywhere(packed);
+  packed.end();
+
+  CHECK(unpacked.begin());
+  unpacked.fillScreen(0x7BEF);
+  toggleEverywhere(unpacked);
+  unpacked.end();
+
+  // Not for double-buffered panels
+  RGBmatrixPanel dbuf(A0, A1, A2, D6, TX, D7, true);
+  CHECK(dbuf.begin());
+  CHECK(!dbuf.setLineBuffer(true));
+  dbuf.end();
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+/*
+Host test for RGBmatrixReceiver: row chunks are fed through an in-memory
+pipe standing in for Serial or a TCPClient, a few bytes available at a
+time, and the panel's buffers are checked against the same picture drawn
+directly.  Uses the Particle stand-ins in this directory.
+
+Build and run (from this directory):
+
+  g++ -std=gnu++11 -Wall -DPLATFORM_ID=6 -DSTM32F2XX -I. -I../../src \
+    -o receiver_test receiver_test.cpp host.cpp \
+    ../../src/RGBmatrixPanel.cpp ../../src/RGBmatrixFrames.cpp \
+    ../../src/RGBmatrixReceiver.cpp && ./receiver_test
+
+Prints each failed check and exits non-zero if there were any.
+*/
+
+#include <stdio.h>
+#include <vector>
+#include "RGBmatrixPanel.h"
+#include "RGBmatrixReceiver.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { if(!(cond)) { \
+  printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+} while(0)
+
+// Bytes written are read back in order; at most 'burst' are reported as
+// available at once, so chunks arrive split across rows and polls.
+class Pipe : public Stream {
+ public:
+  std::vector<uint8_t> data;
+  size_t               pos, burst;
+
+  Pipe(void) : pos(0), burst(7) { }
+  int available(void) {
+    size_t n = data.size() - pos;
+    return (int)((n > burst) ? burst : n);
+  }
+  int read(void)  { return (pos < data.size()) ? data[pos++] : -1; }
+  int peek(void)  { return (pos < data.size()) ? data[pos]   : -1; }
+  size_t write(uint8_t c) {
+    data.push_back(c);
+    return 1;
+  }
+  void header(uint8_t format, uint8_t first, uint8_t count) {
+    write(RECEIVE_SYNC);
+    write(format);
+    write(first);
+    write(count);
+  }
+};
+
+#define WIDTH  32
+#define HEIGHT 16
+
+// Test picture: a different color for every pixel, all 4 bits of each
+// channel exercised
+static uint16_t pattern(int x, int y, int seed) {
+  uint8_t r = (x + seed) & 15, g = (y * 3 + seed) & 15, b = (x ^ y) & 15;
+  return (r << 12) | ((r & 8) << 8) | (g << 7) | ((g & 0xC) << 3) |
+         (b << 1) | (b >> 3);
+}
+
+// 'rows' rows of the test picture as 5/6/5, little-endian
+static void send565(Pipe &p, int first, int rows, int seed) {
+  int x, y;
+  p.header(RECEIVE_565, first, rows);
+  for(y=first; y<first+rows; y++) {
+    for(x=0; x<WIDTH; x++) {
+      uint16_t c = pattern(x, y, seed);
+      p.write(c & 0xFF);
+      p.write(c >> 8);
+    }
+  }
+}
+
+// Draw the test picture on a panel that isn't refreshed, for its buffer
+// bytes as sent in packed form or expected after a 5/6/5 frame
+static std::vector<uint8_t> reference(int seed) {
+  RGBmatrixPanel ref(A0, A1, A2, D6, TX, D7, false);
+  int            x, y;
+  for(y=0; y<HEIGHT; y++)
+    for(x=0; x<WIDTH; x++) ref.drawPixel(x, y, pattern(x, y, seed));
+  return std::vector<uint8_t>(ref.backBuffer(),
+    ref.backBuffer() + ref.scanRows() * ref.scanLineBytes());
+}
+
+// Bytes of the buffer currently shown.  Swaps it to the back to read it
+// (and back again), as the panel only exposes the back buffer.
+static std::vector<uint8_t> shown(RGBmatrixPanel &m) {
+  m.swapBuffers(false);
+  std::vector<uint8_t> v(m.backBuffer(),
+    m.backBuffer() + m.scanRows() * m.scanLineBytes());
+  m.swapBuffers(false);
+  return v;
+}
+
+static int pollAll(RGBmatrixReceiver &rx, Pipe &p) {
+  int n = 0;
+  while(p.available()) n += rx.poll();
+  return n;
+}
+
+int main(void) {
+  RGBmatrixPanel    matrix(A0, A1, A2, D6, TX, D7, true);
+  Pipe              pipe;
+  RGBmatrixReceiver rx(matrix, pipe);
+  uint8_t          *back;
+  uint32_t          errors;
+  int               i;
+
+  matrix.begin();
+  std::vector<uint8_t> pic1 = reference(1), pic2 = reference(2);
+
+  // 5/6/5 frame in four chunks, after garbage: the receiver resyncs on
+  // the first RECEIVE_SYNC, counting each discarded byte as an error.
+  // The buffers are swapped once, when the last row arrives.
+  pipe.write(0x00);
+  pipe.write(0x42);
+  pipe.write(0xFF);
+  back = matrix.backBuffer();
+  for(i=0; i<HEIGHT; i+=4) send565(pipe, i, 4, 1);
+  CHECK(pollAll(rx, pipe) == 1);
+  CHECK(rx.frameCount() == 1);
+  CHECK(rx.errorCount() == 3);
+  CHECK(matrix.backBuffer() != back);
+  CHECK(shown(matrix) == pic1);
+
+  // Packed frame: scanlines go straight into the back buffer
+  pipe.header(RECEIVE_PACKED, 0, matrix.scanRows());
+  for(i=0; i<(int)pic2.size(); i++) pipe.write(pic2[i]);
+  CHECK(pollAll(rx, pipe) == 1);
+  CHECK(rx.frameCount() == 2);
+  CHECK(shown(matrix) == pic2);
+
+  // Truncated chunk: no swap while rows are missing, and the frame
+  // completes once the rest of the chunk turns up
+  errors = rx.errorCount();
+  back   = matrix.backBuffer();
+  send565(pipe, 0, HEIGHT, 1);
+  std::vector<uint8_t> tail(pipe.data.end() - WIDTH * 3, pipe.data.end());
+  pipe.data.resize(pipe.data.size() - tail.size());
+  CHECK(pollAll(rx, pipe) == 0);
+  CHECK(rx.frameCount() == 2);
+  CHECK(matrix.backBuffer() == back);
+  CHECK(shown(matrix) == pic2);
+  pipe.data.insert(pipe.data.end(), tail.begin(), tail.end());
+  CHECK(pollAll(rx, pipe) == 1);
+  CHECK(rx.frameCount() == 3);
+  CHECK(rx.errorCount() == errors);
+  CHECK(shown(matrix) == pic1);
+
+  // Chunks reaching past the last row or scanline, or of no rows, or of
+  // an unknown format, are dropped with their payload; a good chunk
+  // straight after is still taken
+  errors = rx.errorCount();
+  send565(pipe, HEIGHT - 2, 4, 2);
+  pipe.header(RECEIVE_PACKED, matrix.scanRows(), 1);
+  for(i=0; i<matrix.scanLineBytes(); i++) pipe.write(0);
+  pipe.header(RECEIVE_PACKED, 0, 0);
+  pipe.header('?', 0, 1);
+  CHECK(pollAll(rx, pipe) == 0);
+  CHECK(rx.frameCount() == 3);
+  CHECK(shown(matrix) == pic1);
+  CHECK(rx.errorCount() > errors + 4);
+  pipe.header(RECEIVE_PACKED, 0, matrix.scanRows());
+  for(i=0; i<(int)pic2.size(); i++) pipe.write(pic2[i]);
+  CHECK(pollAll(rx, pipe) == 1);
+  CHECK(shown(matrix) == pic2);
+
+  // A chunk ending short of the last row updates the back buffer only
+  errors = rx.errorCount();
+  back   = matrix.backBuffer();
+  send565(pipe, 0, HEIGHT / 2, 1);
+  CHECK(pollAll(rx, pipe) == 0);
+  CHECK(matrix.backBuffer() == back);
+  CHECK(rx.errorCount() == errors);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+/*
+Host test for RGBmatrixPanel::reconfigure() on a scan-banded panel and on
+parallel chains: widths the scan pattern or chains can't take are
+refused without touching the panel, and after a good one every pixel
+lands on its own spot inside the buffer.  Uses the Particle stand-ins in
+this directory.
+
+Build and run (from this directory):
+
+  g++ -std=gnu++11 -Wall -DPLATFORM_ID=6 -DSTM32F2XX -I. -I../../src \
+    -o reconfigure_test reconfigure_test.cpp host.cpp \
+    ../../src/RGBmatrixPanel.cpp ../../src/RGBmatrixFrames.cpp && \
+    ./reconfigure_test
+
+Prints each failed check and exits non-zero if there were any.
+*/
+
+#include <stdio.h>
+#include "RGBmatrixPanel.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { if(!(cond)) { \
+  printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+} while(0)
+
+// Light every pixel in white, one at a time, and check every bit of the
+// back buffer was set: with 4 planes of 6 color bits each, white fills
+// every byte in either layout, so any two pixels mapped to the same spot
+// leave some other spot empty.
+static bool coversBuffer(RGBmatrixPanel &m) {
+  uint8_t *buf = m.backBuffer();
+  uint32_t n   = (uint32_t)m.scanRows() * m.scanLineBytes(), i;
+  int16_t  x, y;
+
+  if(!buf) return false;
+  memset(buf, 0, n);
+  for(y=0; y<m.height(); y++)
+    for(x=0; x<m.width(); x++) m.drawPixel(x, y, 0xFFFF);
+  for(i=0; (i<n) && (buf[i] == 0xFF); i++);
+  return (i == n);
+}
+
+// Copy a full white buffer over a cleared back buffer with each
+// copyRect(), checking every byte comes through.
+static bool copiesBuffer(RGBmatrixPanel &m) {
+  uint32_t n = (uint32_t)m.scanRows() * m.scanLineBytes(), i;
+  uint8_t *src = (uint8_t *)malloc(n), *buf = m.backBuffer();
+  bool     ok;
+
+  if(!src || !buf) return false;
+  memset(src, 0xFF, n);
+  memset(buf, 0, n);
+  m.copyRect(src, 0, 0, m.width(), m.height());
+  for(i=0; (i<n) && (buf[i] == 0xFF); i++);
+  ok = (i == n);
+  memset(buf, 0, n);
+  m.copyRect(src, 0, 0, 0, 0, m.width(), m.height());
+  for(i=0; (i<n) && (buf[i] == 0xFF); i++);
+  free(src);
+  return ok && (i == n);
+}
+
+int main(void) {
+  RGBmatrixPanel matrix(A0, A1, A2, A3, D6, TX, D7, true, 32);
+  static const uint8_t pins[12] = { A4, A5, A6, A7, RX, WKP,
+                                    D0, D1, D2, D3, D4, D5 };
+  uint8_t *back;
+
+  CHECK(matrix.begin());
+
+  // 1/8 scan on 32 rows: two bands of rows per half, interleaved in
+  // blocks of 16 columns, so the chain is twice the width
+  CHECK(matrix.setScanPattern(8, 16));
+  CHECK(matrix.scanRows() == 8);
+  CHECK(coversBuffer(matrix));
+
+  // 40 isn't a whole number of blocks: refused, panel untouched
+  back = matrix.backBuffer();
+  CHECK(!matrix.reconfigure(40, true));
+  CHECK(matrix.width() == 32);
+  CHECK(matrix.backBuffer() == back);
+  CHECK(coversBuffer(matrix));
+
+  // Wider and then single-buffered, keeping the scan pattern
+  CHECK(matrix.reconfigure(64, true));
+  CHECK((matrix.width() == 64) && (matrix.height() == 32));
+  CHECK(matrix.scanRows() == 8);
+  CHECK(coversBuffer(matrix));
+  CHECK(matrix.reconfigure(48, false));
+  CHECK(matrix.width() == 48);
+  CHECK(coversBuffer(matrix));
+
+  // Three parallel chains need a width they divide evenly
+  CHECK(matrix.setScanPattern(16));
+  CHECK(matrix.reconfigure(96, true));
+  CHECK(!matrix.setParallelChains(3, NULL));
+  CHECK(matrix.setParallelChains(3, pins));
+  CHECK(!matrix.reconfigure(64, true));
+  CHECK(matrix.width() == 96);
+  CHECK(coversBuffer(matrix));
+  CHECK(matrix.reconfigure(192, true));
+  CHECK(matrix.width() == 192);
+  CHECK(coversBuffer(matrix));
+
+  // Wide enough for buffer offsets past 64K: whole-buffer copies, at
+  // the same spot and moved, still land everywhere
+  CHECK(matrix.reconfigure(1440, false));
+  CHECK((uint32_t)matrix.scanRows() * matrix.scanLineBytes() > 65535);
+  CHECK(coversBuffer(matrix));
+  CHECK(copiesBuffer(matrix));
+
+  CHECK(!matrix.reconfigure(0, true));
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
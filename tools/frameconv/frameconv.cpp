@@ -0,0 +1,267 @@
+/*
+frameconv: host-side converter from PNG images (and, optionally, GIF
+animations) to RGBmatrixPanel frame files (see src/RGBmatrixFrames.h),
+so images and animations can be prepared offline instead of on a device
+with dumpMatrix().  Pixels go through the same gamma_lut and bitplane
+packing as the library's Color888(..., true) and drawPixel(), for a
+plain chain of panels (no setScanPattern() or setTiling() remapping):
+one column per pixel, height/2 scanlines.
+
+Build (needs libpng):
+
+  g++ -O2 -I../../src -o frameconv frameconv.cpp \
+    ../../src/RGBmatrixFrames.cpp -lpng
+
+For GIF input also add -DFRAMECONV_GIF and an include path to a copy of
+stb_image.h (https://github.com/nothings/stb, not included here).
+
+Usage:
+
+  frameconv [options] -o out.rgbf frame1.png [frame2.png ...]
+
+  -o file   Output file
+  -c name   Write a C array named 'name' instead of a binary file
+  -u        LAYOUT_UNPACKED buffer (default LAYOUT_PACKED)
+  -z        Run-length compress frames where that's smaller
+  -d ms     Delay after each frame (default 100; GIFs keep their own)
+  -l        Linear color, no gamma correction
+
+Every image must be the panel's full size: width a multiple of 32, height
+16, 32 or 64.
+
+BSD license, all text above must be included in any redistribution.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <vector>
+#include <png.h>
+#include "RGBmatrixFrames.h"
+#include "gamma.h"
+#ifdef FRAMECONV_GIF
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_GIF
+#include "stb_image.h"
+#endif
+
+#define nPlanes 4
+
+struct Image {
+  int                  w, h;
+  uint16_t             delay;
+  std::vector<uint8_t> rgb; // 8/8/8
+};
+
+static bool loadPNG(const char *name, uint16_t delay,
+  std::vector<Image> &images) {
+  png_image png;
+  Image     img;
+
+  memset(&png, 0, sizeof(png));
+  png.version = PNG_IMAGE_VERSION;
+  if(!png_image_begin_read_from_file(&png, name)) {
+    fprintf(stderr, "%s: %s\n", name, png.message);
+    return false;
+  }
+  png.format = PNG_FORMAT_RGB;
+  img.w      = png.width;
+  img.h      = png.height;
+  img.delay  = delay;
+  img.rgb.resize(PNG_IMAGE_SIZE(png));
+  if(!png_image_finish_read(&png, NULL, &img.rgb[0], 0, NULL)) {
+    fprintf(stderr, "%s: %s\n", name, png.message);
+    png_image_free(&png);
+    return false;
+  }
+  images.push_back(img);
+  return true;
+}
+
+#ifdef FRAMECONV_GIF
+static bool loadGIF(const char *name, std::vector<Image> &images) {
+  std::vector<uint8_t> file;
+  FILE    *f = fopen(name, "rb");
+  int     *delays = NULL, w, h, frames, comp, i;
+  uint8_t *data;
+  long     len;
+
+  if(f == NULL) {
+    perror(name);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  len = ftell(f);
+  rewind(f);
+  file.resize(len);
+  len = fread(&file[0], 1, len, f);
+  fclose(f);
+
+  data = stbi_load_gif_from_memory(&file[0], len, &delays, &w, &h, &frames,
+    &comp, 3);
+  if(data == NULL) {
+    fprintf(stderr, "%s: %s\n", name, stbi_failure_reason());
+    return false;
+  }
+  for(i=0; i<frames; i++) {
+    Image img;
+    img.w     = w;
+    img.h     = h;
+    img.delay = delays ? delays[i] : 100;
+    img.rgb.assign(data + i * w * h * 3, data + (i + 1) * w * h * 3);
+    images.push_back(img);
+  }
+  stbi_image_free(data);
+  free(delays);
+  return true;
+}
+#endif
+
+// Pack one image into matrix buffer format.  Mirrors the library's
+// encodeRGB(): R,G,B of each plane in bits 2-4 (upper half of the
+// display) or 5-7 (lower half); packed, plane 0 goes in the spare low
+// bits of the three bytes holding planes 1-3.
+static void pack(const Image &img, bool unpacked, bool gamma,
+  std::vector<uint8_t> &out) {
+  int      rows = img.h / 2, planeRows = unpacked ? nPlanes : nPlanes - 1,
+           x, y, p, s;
+  uint8_t  c[3], r, g, b, *ptr;
+  bool     lower;
+
+  out.assign(img.w * rows * planeRows, 0);
+  for(y=0; y<img.h; y++) {
+    for(x=0; x<img.w; x++) {
+      memcpy(c, &img.rgb[(y * img.w + x) * 3], 3);
+      r = gamma ? gamma_lut[c[0]] : (c[0] >> 4);
+      g = gamma ? gamma_lut[c[1]] : (c[1] >> 4);
+      b = gamma ? gamma_lut[c[2]] : (c[2] >> 4);
+      lower = (y >= rows);
+      s     = lower ? 5 : 2;
+      ptr   = &out[(y % rows) * img.w * planeRows + x];
+      for(p = unpacked ? 0 : 1; p < nPlanes; p++, ptr += img.w)
+        *ptr |= (((r >> p) & 1) | (((g >> p) & 1) << 1) |
+                 (((b >> p) & 1) << 2)) << s;
+      if(unpacked) continue;
+      ptr = &out[(y % rows) * img.w * planeRows + x];
+      if(lower) {
+        ptr[0]     |= (g & 1) | ((b & 1) << 1);
+        ptr[img.w] |= (r & 1) << 1;
+      } else {
+        ptr[img.w]     |=  b & 1;
+        ptr[img.w * 2] |= (r & 1) | ((g & 1) << 1);
+      }
+    }
+  }
+}
+
+static void usage(void) {
+  fprintf(stderr,
+    "usage: frameconv [-u] [-z] [-l] [-d ms] [-c name] -o out images...\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<Image>   images;
+  std::vector<uint8_t> file, frame, packed;
+  FrameFileInfo        info;
+  FrameInfo            fi;
+  const char          *outName = NULL, *arrayName = NULL;
+  bool                 unpacked = false, compress = false, gamma = true;
+  uint16_t             delay = 100;
+  uint32_t             bytes, n, i;
+  FILE                *f;
+  int                  opt;
+
+  while((opt = getopt(argc, argv, "o:c:uzd:l")) != -1) {
+    switch(opt) {
+     case 'o': outName   = optarg;       break;
+     case 'c': arrayName = optarg;       break;
+     case 'u': unpacked  = true;         break;
+     case 'z': compress  = true;         break;
+     case 'd': delay     = atoi(optarg); break;
+     case 'l': gamma     = false;        break;
+     default:  usage();
+    }
+  }
+  if((outName == NULL) || (optind >= argc)) usage();
+
+  for(; optind < argc; optind++) {
+    const char *name = argv[optind], *ext = strrchr(name, '.');
+    if(ext && !strcasecmp(ext, ".gif")) {
+#ifdef FRAMECONV_GIF
+      if(!loadGIF(name, images)) return 1;
+#else
+      fprintf(stderr, "%s: built without GIF support\n", name);
+      return 1;
+#endif
+    } else if(!loadPNG(name, delay, images)) {
+      return 1;
+    }
+  }
+
+  info.version = FRAMEFILE_VERSION;
+  info.layout  = unpacked ? 1 : 0; // LAYOUT_UNPACKED : LAYOUT_PACKED
+  info.planes  = nPlanes;
+  info.width   = images[0].w;
+  info.height  = images[0].h;
+  info.rows    = images[0].h / 2;
+  info.columns = images[0].w;
+  info.frames  = images.size();
+  if((info.width % 32) || ((info.height != 16) && (info.height != 32) &&
+     (info.height != 64))) {
+    fprintf(stderr, "%dx%d isn't a panel size\n", info.width, info.height);
+    return 1;
+  }
+  bytes = frameBytes(info);
+
+  file.resize(FRAMEFILE_HEADER);
+  frameFileHeader(&file[0], info);
+  for(i=0; i<images.size(); i++) {
+    if((images[i].w != info.width) || (images[i].h != info.height)) {
+      fprintf(stderr, "frame %u: size differs from the first\n", i);
+      return 1;
+    }
+    pack(images[i], unpacked, gamma, packed);
+    fi.delay    = images[i].delay;
+    fi.checksum = frameChecksum(&packed[0], bytes);
+    frame.resize(bytes);
+    n = compress ? frameCompress(&packed[0], bytes, &frame[0], bytes - 1) : 0;
+    if(n) {
+      fi.compression = FRAMEFILE_RLE;
+      fi.size        = n;
+    } else {
+      fi.compression = FRAMEFILE_RAW;
+      fi.size        = bytes;
+      frame          = packed;
+    }
+    n = file.size();
+    file.resize(n + FRAMEFILE_FRAME + fi.size);
+    frameHeader(&file[n], fi);
+    memcpy(&file[n + FRAMEFILE_FRAME], &frame[0], fi.size);
+  }
+
+  if((f = fopen(outName, arrayName ? "w" : "wb")) == NULL) {
+    perror(outName);
+    return 1;
+  }
+  if(arrayName) {
+    // Same form as dumpMatrix() output, for compiling into firmware
+    fprintf(f, "static const uint8_t PROGMEM %s[] = {\n  ", arrayName);
+    for(i=0; i<file.size(); i++) {
+      fprintf(f, "0x%02X", file[i]);
+      if(i < (file.size() - 1)) fputs(((i & 7) == 7) ? ",\n  " : ",", f);
+    }
+    fputs("\n};\n", f);
+  } else {
+    fwrite(&file[0], 1, file.size(), f);
+  }
+  if(fclose(f)) {
+    perror(outName);
+    return 1;
+  }
+  printf("%s: %u frame(s), %u bytes\n", outName, info.frames,
+    (uint32_t)file.size());
+  return 0;
+}